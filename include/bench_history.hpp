@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * One throughput number from a benchmark run. The unit decides which
+ * direction is worse: "ns/op" regresses upwards, rates ("nodes/s",
+ * "games/s") regress downwards.
+ */
+struct BenchMetric {
+    std::string name;
+    std::string unit;
+    double value = 0;
+
+    [[nodiscard]] bool higherIsBetter() const { return unit != "ns/op"; }
+};
+
+struct BenchRun {
+    std::string commit;
+    std::string cpu;
+    std::string time;           // UTC, ISO 8601
+    uint64_t seed = 0;
+    double scale = 1.0;         // Runs are only compared with runs of the same seed and scale
+    int repeat = 0;
+    std::vector<BenchMetric> metrics;
+
+    [[nodiscard]] const BenchMetric* find(const std::string& name) const;
+};
+
+/**
+ * A metric of the current run against the same metric in the previous runs.
+ * The previous values give a mean and sample standard deviation; the current
+ * value is a regression when it is worse than the mean by more than the
+ * relative threshold and falls outside the two-sided 95% Student t
+ * prediction interval for a new observation, mean +/- t * s * sqrt(1 + 1/n).
+ * Below MIN_BASELINE_RUNS previous values the spread is too poorly known and
+ * nothing is flagged.
+ */
+struct BenchComparison {
+    BenchMetric metric;
+    size_t baselineRuns = 0;
+    double baselineMean = 0;
+    double baselineStddev = 0;
+    double change = 0;          // Relative change of the value, positive = better
+    bool regression = false;
+};
+
+/**
+ * Benchmark history, a JSON Lines file with one run object per line so
+ * recording a run is an append and the file stays valid if a run is cut
+ * short. Lines that fail to parse are skipped with a warning.
+ */
+class BenchHistory {
+public:
+    static constexpr size_t MIN_BASELINE_RUNS = 3;
+
+    // A missing file is an empty history
+    bool load(const std::string& path);
+    static bool append(const std::string& path, const BenchRun& run);
+
+    [[nodiscard]] const std::vector<BenchRun>& runs() const { return runs_; }
+
+    // Up to count most recent runs comparable with run: same CPU model, seed and scale
+    [[nodiscard]] std::vector<const BenchRun*> baseline(const BenchRun& run, size_t count) const;
+
+    // One comparison per metric of run, in the run's order
+    [[nodiscard]] std::vector<BenchComparison> compare(const BenchRun& run, size_t count, double threshold) const;
+
+private:
+    std::vector<BenchRun> runs_;
+};
+
+// Short commit id of the working tree from git ("-dirty" if modified), "unknown" outside a repository
+std::string currentCommit();
+
+// CPU model name from /proc/cpuinfo, "unknown" if unavailable
+std::string cpuModel();
+
+// Current time as e.g. 2024-01-31T12:00:00Z
+std::string utcTimestamp();
+
+} // namespace BlockGame
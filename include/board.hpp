@@ -62,6 +62,10 @@ public:
     [[nodiscard]] std::vector<Move> getLegalMoves(const Piece& piece) const;
     [[nodiscard]] int countValidPlacements(PieceType type) const;
 
+    // Bitboard of every origin (row * 8 + col) where the piece fits.
+    // Computed by eroding the empty squares with each cell of the piece, no per-position loop.
+    [[nodiscard]] uint64_t fitMask(const Piece& piece) const;
+
     // Place a piece (OR operation), does NOT clear lines
     void place(uint64_t pieceMask) {
         data_ |= pieceMask;
@@ -73,6 +77,41 @@ public:
     // Clear full rows and columns, returns count of cleared lines
     int clearFullLines();
 
+    // Would placing pieceMask complete a row or column? lines is linesTouched(pieceMask),
+    // normally looked up in the piece's shift table. The board is not changed.
+    [[nodiscard]] bool wouldClear(uint64_t pieceMask, uint16_t lines) const {
+        return (fullLines(data_ | pieceMask) & lines) != 0;
+    }
+    [[nodiscard]] bool wouldClear(uint64_t pieceMask) const {
+        return wouldClear(pieceMask, linesTouched(pieceMask));
+    }
+
+    // The origins in fits (e.g. from fitMask) where placing the piece clears at least one line
+    [[nodiscard]] uint64_t clearingFits(const Piece& piece, uint64_t fits) const;
+
+    // Line sets: rows in bits 0-7, columns in bits 8-15.
+    // Completely filled lines, by the same shift-and reduction clearFullLines uses.
+    [[nodiscard]] static constexpr uint16_t fullLines(uint64_t data) {
+        uint64_t r = data & (data >> 1);
+        r &= r >> 2;
+        r &= r >> 4;
+        uint64_t c = data & (data >> 8);
+        c &= c >> 16;
+        c &= c >> 32;
+        return static_cast<uint16_t>(gatherRows(r) | (c & 0xFF) << 8);
+    }
+
+    // Lines with at least one square of mask, the same reduction with OR
+    [[nodiscard]] static constexpr uint16_t linesTouched(uint64_t mask) {
+        uint64_t r = mask | (mask >> 1);
+        r |= r >> 2;
+        r |= r >> 4;
+        uint64_t c = mask | (mask >> 8);
+        c |= c >> 16;
+        c |= c >> 32;
+        return static_cast<uint16_t>(gatherRows(r) | (c & 0xFF) << 8);
+    }
+
     // String representation for debugging/display
     [[nodiscard]] std::string toString() const;
 
@@ -90,6 +129,12 @@ private:
     static constexpr uint64_t bitAt(int row, int col) {
         return 1ULL << (row * 8 + col);
     }
+
+    // Bit 0 of each row (bits 0, 8, ..., 56) packed into one byte, row i -> bit i.
+    // The multiply moves bit 8i to 56 + i; no two partial products overlap.
+    static constexpr uint64_t gatherRows(uint64_t bits) {
+        return ((bits & COL_MASK) * 0x0102040810204080ULL) >> 56;
+    }
 };
 
 } // namespace BlockGame
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "game.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * One training sample: the position before a placement, the placement chosen,
+ * and how the game turned out. Fixed 32-byte stride so shards can be mmapped
+ * and indexed directly.
+ */
+struct DatasetSample {
+    uint64_t board;         // Board before the move
+    uint8_t hand[3];        // Piece types in hand, UNUSED_SLOT for already placed pieces
+    uint8_t moveSlot;       // Hand slot that was placed
+    uint8_t movePos;        // row * 8 + col of the placement
+    uint8_t linesCleared;   // Lines cleared by this move
+    uint16_t turn;          // Turn number (1-based)
+    int32_t scoreBefore;    // Score before the move
+    int32_t finalScore;     // Score at game over
+    int32_t returnToGo;     // finalScore - scoreBefore
+    uint32_t gameIndex;     // Index of the game within its shard
+
+    static constexpr uint8_t UNUSED_SLOT = 0xFF;
+};
+static_assert(sizeof(DatasetSample) == 32, "DatasetSample must keep a 32-byte stride");
+
+/**
+ * Shard file layout: 32-byte header (magic "BGDS", u16 version, u16 stride,
+ * u32 reserved, u64 sample count, u64 reserved x2) followed by count samples.
+ */
+namespace Dataset {
+    constexpr char MAGIC[4] = {'B', 'G', 'D', 'S'};
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t HEADER_BYTES = 32;
+    constexpr size_t CHUNK_SAMPLES = 4096;  // Samples buffered per write
+}
+
+/**
+ * Records every placement of the games it is attached to into one shard.
+ *
+ * With a reservoir capacity the shard holds a uniform random subset of all
+ * placements seen (algorithm R), so the dataset size stays bounded however many
+ * games are played; samples are then written at close(). Without one, samples
+ * are streamed to disk in chunks.
+ */
+class DatasetWriter : public GameRecorder {
+public:
+    DatasetWriter() = default;
+    ~DatasetWriter() override;
+
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+
+    // reservoirCapacity 0 keeps every sample
+    bool open(const std::string& path, uint64_t reservoirCapacity, uint64_t seed);
+    bool close();
+
+    [[nodiscard]] uint64_t samplesSeen() const { return seen_; }
+    [[nodiscard]] uint64_t samplesWritten() const { return written_; }
+
+    void beginGame(uint64_t seed, const Game& game) override;
+    void onHandDrawn(const Game& game) override;
+    void onPlacement(const Game& game, int handIndex, int row, int col, int linesCleared) override;
+    void endGame(const Game& game) override;
+
+private:
+    std::FILE* file_ = nullptr;
+    bool failed_ = false;
+    uint64_t capacity_ = 0;
+    uint64_t seen_ = 0;
+    uint64_t written_ = 0;
+    uint32_t games_ = 0;
+    std::mt19937_64 rng_;
+
+    uint64_t boardBefore_ = 0;
+    std::vector<DatasetSample> pending_;    // Current game, waiting for the final score
+    std::vector<DatasetSample> reservoir_;
+    std::vector<DatasetSample> chunk_;
+
+    void writeSamples(const DatasetSample* samples, size_t count);
+};
+
+/**
+ * Memory-mapped view of one shard
+ */
+class DatasetShard {
+public:
+    DatasetShard() = default;
+    ~DatasetShard();
+
+    DatasetShard(const DatasetShard&) = delete;
+    DatasetShard& operator=(const DatasetShard&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    [[nodiscard]] size_t size() const { return count_; }
+    [[nodiscard]] const DatasetSample* samples() const { return samples_; }
+    [[nodiscard]] const DatasetSample& operator[](size_t i) const { return samples_[i]; }
+
+private:
+    void* mapping_ = nullptr;
+    size_t mappedBytes_ = 0;
+    const DatasetSample* samples_ = nullptr;
+    size_t count_ = 0;
+};
+
+// Write DIR/index.txt listing every shard file name with its sample count
+bool writeDatasetIndex(const std::string& dir, const std::vector<std::string>& shardNames,
+                       const std::vector<uint64_t>& counts);
+
+} // namespace BlockGame
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "evaluator.hpp"
+#include "planner.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * Exact solver for nearly full boards.
+ *
+ * Computes, over the next `hands` random hands, either the probability of
+ * placing every hand (SURVIVAL) or the expected points earned when each hand is
+ * played to maximise that expectation (SCORE). Every one of the NUM_PIECES^3
+ * ordered hands is covered by enumerating hand multisets with their
+ * multiplicities, and each hand is expanded with a HandPlanner, so piece order
+ * and transpositions are handled exactly. Results are memoized per remaining
+ * hand count, keyed on Board::data().
+ *
+ * The search stays exact while boards keep at most `maxEmpty` empty squares.
+ * A hand that clears lines and leaves more than that has escaped the endgame:
+ * it counts as surviving the rest of the horizon, and in SCORE mode contributes
+ * only the points earned so far.
+ */
+class EndgameSolver {
+public:
+    enum class Objective : uint32_t {
+        SURVIVAL = 0,
+        SCORE = 1,
+    };
+
+    struct Config {
+        int maxEmpty = 10;
+        int hands = 1;
+        Objective objective = Objective::SURVIVAL;
+        bool clearingFirst = true;      // Move ordering of the last-hand feasibility search
+    };
+
+    explicit EndgameSolver(const Config& config);
+
+    [[nodiscard]] const Config& config() const { return config_; }
+
+    // True if board is inside the solved region
+    [[nodiscard]] bool inRange(const Board& board) const;
+
+    // Value of board over config().hands hands. Board must be inRange().
+    double solve(const Board& board);
+
+    // Boards solved at the full horizon, i.e. what save() writes
+    [[nodiscard]] size_t size() const { return memo_[config_.hands].size(); }
+
+    // Write every full-horizon result as a sorted tablebase
+    bool save(const std::string& path) const;
+
+    // Cutoff statistics of the last-hand feasibility searches so far
+    [[nodiscard]] CutoffHistogram cutoffs() const;
+
+private:
+    Config config_;
+    std::vector<std::unordered_map<uint64_t, double>> memo_;    // Indexed by hands remaining
+    std::vector<HandPlanner> planners_;                         // One per recursion level
+
+    double solve(uint64_t board, int hands);
+};
+
+/**
+ * Memory-mapped tablebase written by EndgameSolver::save().
+ *
+ * Layout: 32-byte header (magic "BGTB", u32 version, u32 hands, u32 max empty,
+ * u32 objective, u32 reserved, u64 entry count) followed by entries sorted by
+ * board, so a probe is one binary search over the mapping.
+ */
+class EndgameTablebase {
+public:
+    struct Entry {
+        uint64_t board;
+        double value;
+    };
+
+    EndgameTablebase() = default;
+    ~EndgameTablebase();
+
+    EndgameTablebase(const EndgameTablebase&) = delete;
+    EndgameTablebase& operator=(const EndgameTablebase&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    [[nodiscard]] size_t size() const { return count_; }
+    [[nodiscard]] int hands() const { return hands_; }
+    [[nodiscard]] int maxEmpty() const { return maxEmpty_; }
+    [[nodiscard]] EndgameSolver::Objective objective() const { return objective_; }
+
+    // O(log n) lookup, false if the board is not in the table
+    bool probe(const Board& board, double& value) const;
+
+private:
+    void* mapping_ = nullptr;
+    size_t mappedBytes_ = 0;
+    const Entry* entries_ = nullptr;
+    size_t count_ = 0;
+    int hands_ = 0;
+    int maxEmpty_ = 0;
+    EndgameSolver::Objective objective_ = EndgameSolver::Objective::SURVIVAL;
+};
+
+/**
+ * Evaluator that defers to a survival tablebase on nearly full boards.
+ * A board found in the table gets base value minus penalty * (1 - survival),
+ * so lines of play that are provably risky lose to safe ones; other boards
+ * are left to the base evaluator.
+ */
+class EndgameEvaluator : public Evaluator {
+public:
+    EndgameEvaluator(std::shared_ptr<const Evaluator> base, std::shared_ptr<const EndgameTablebase> table,
+                     double penalty)
+        : base_(std::move(base)), table_(std::move(table)), penalty_(penalty) {}
+
+    [[nodiscard]] double evaluate(const Board& board) const override;
+
+private:
+    std::shared_ptr<const Evaluator> base_;
+    std::shared_ptr<const EndgameTablebase> table_;
+    double penalty_;
+};
+
+} // namespace BlockGame
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "board.hpp"
+#include <array>
+#include <string>
+
+namespace BlockGame {
+
+/**
+ * Static evaluation of a board after a hand has been placed.
+ * Values are in score units so they can be added to points earned along a line of play.
+ */
+class Evaluator {
+public:
+    virtual ~Evaluator() = default;
+
+    [[nodiscard]] virtual double evaluate(const Board& board) const = 0;
+};
+
+// Cheap bitboard features used by the heuristic evaluator
+enum Feature {
+    FEATURE_EMPTY_SQUARES = 0,  // Number of empty squares
+    FEATURE_ISOLATED_HOLES,     // Empty squares with no empty orthogonal neighbour
+    FEATURE_TRANSITIONS,        // Empty/filled boundaries along rows and columns
+    FEATURE_PLACEABLE_PIECES,   // Piece types with at least one legal placement
+    FEATURE_MOBILITY,           // Total legal placements over all piece types
+
+    FEATURE_COUNT
+};
+
+constexpr int NUM_FEATURES = static_cast<int>(FEATURE_COUNT);
+
+using FeatureVector = std::array<double, NUM_FEATURES>;
+
+// Compute all features for a board
+FeatureVector computeFeatures(const Board& board);
+
+// Short identifier for a feature, used in weight files and reports
+const char* featureName(Feature feature);
+
+/**
+ * Linear weights over the feature vector
+ */
+struct HeuristicWeights {
+    FeatureVector w;
+
+    static HeuristicWeights defaults();
+
+    // Text format, one "feature_name value" pair per line. Missing features keep their defaults.
+    // Returns false if the file cannot be read or names an unknown feature.
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+};
+
+/**
+ * Linear combination of hand-crafted board features
+ */
+class HeuristicEvaluator : public Evaluator {
+public:
+    HeuristicEvaluator() : weights_(HeuristicWeights::defaults()) {}
+    explicit HeuristicEvaluator(const HeuristicWeights& weights) : weights_(weights) {}
+
+    [[nodiscard]] double evaluate(const Board& board) const override;
+
+    [[nodiscard]] const HeuristicWeights& weights() const { return weights_; }
+
+private:
+    HeuristicWeights weights_;
+};
+
+} // namespace BlockGame
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "board.hpp"
+#include "hand_cache.hpp"
 #include "pieces.hpp"
 #include <vector>
 #include <array>
@@ -9,6 +10,35 @@
 
 namespace BlockGame {
 
+class Game;
+
+/**
+ * Optional hooks into a running game, e.g. for recording replays.
+ * Callbacks run inline on the thread playing the game.
+ */
+class GameObserver {
+public:
+    virtual ~GameObserver() = default;
+
+    // A new hand was drawn (the hand drawn by the constructor is not reported)
+    virtual void onHandDrawn(const Game& game) = 0;
+
+    // A hand piece was placed and lines cleared; called before the next hand is drawn
+    virtual void onPlacement(const Game& game, int handIndex, int row, int col, int linesCleared) = 0;
+};
+
+/**
+ * Observer that also brackets whole games, attached by the simulation loop
+ */
+class GameRecorder : public GameObserver {
+public:
+    // Called right after Game(seed) is constructed, before any move
+    virtual void beginGame(uint64_t seed, const Game& game) = 0;
+
+    // Called once the game is over
+    virtual void endGame(const Game& game) = 0;
+};
+
 /**
  * Game state and logic
  */
@@ -26,6 +56,7 @@ public:
     [[nodiscard]] const std::array<PieceType, HAND_SIZE>& hand() const { return hand_; }
     [[nodiscard]] const std::array<bool, HAND_SIZE>& handUsed() const { return handUsed_; }
     [[nodiscard]] int turnNumber() const { return turnNumber_; }
+    [[nodiscard]] int movesMade() const { return movesMade_; }
 
     // Check if a specific piece from hand can be placed at position
     [[nodiscard]] bool canPlace(int handIndex, int row, int col) const;
@@ -54,6 +85,13 @@ public:
     // Reset game to initial state
     void reset();
 
+    // Attach an observer (nullptr to detach). Not owned.
+    void setObserver(GameObserver* observer) { observer_ = observer; }
+
+    // Share whole-hand feasibility results with planners (nullptr to detach). Not owned.
+    // A cached "this hand fits" answers the game-over check without scanning placements.
+    void setHandCache(const HandCache* cache) { handCache_ = cache; }
+
     // Calculate score for clearing lines
     static int calculateClearScore(int linesCleared);
 
@@ -68,8 +106,11 @@ public:
     std::array<bool, HAND_SIZE> handUsed_;   // Which pieces have been placed
     int score_;
     int turnNumber_;
+    int movesMade_;
     bool gameOver_;
     std::mt19937 rng_;
+    GameObserver* observer_ = nullptr;
+    const HandCache* handCache_ = nullptr;
 
     void drawHand();
     void checkGameOver();
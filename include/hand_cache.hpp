@@ -0,0 +1,52 @@
+#pragma once
+
+#include "types.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace BlockGame {
+
+/**
+ * Bounded cache of "can this hand be placed in full on this board?".
+ *
+ * Keys are 128 bits: the board and the hand's pieces sorted, so the same
+ * multiset in any slot order shares an entry. Only the answer is kept: the
+ * planners that fill the cache stop at the first line that fits, which says
+ * nothing about the best one.
+ *
+ * The table is direct mapped and shared between threads without locks. Entries
+ * are two 64-bit words written with relaxed stores: the hand with the flags in
+ * its unused high bits, and the board XORed with that word, so a reader that
+ * sees a half-written entry computes a key that does not match and treats it as
+ * a miss.
+ */
+class HandCache {
+public:
+    struct Key {
+        uint64_t board;
+        uint64_t hand;      // Piece count in bits 0-1, sorted pieces 6 bits each from bit 2
+    };
+
+    static constexpr int MAX_BITS = 28;     // 4 GiB
+
+    // 2^bits entries of 16 bytes, bits at most MAX_BITS
+    explicit HandCache(int bits = 20);
+
+    static Key makeKey(uint64_t board, const PieceType* pieces, int count);
+
+    // True on a hit, with the stored answer in feasible
+    bool probe(const Key& key, bool& feasible) const;
+    void store(const Key& key, bool feasible);
+    void clear();
+
+    [[nodiscard]] size_t capacity() const { return mask_ + 1; }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> words_;
+    size_t mask_;
+
+    [[nodiscard]] size_t slot(const Key& key) const;
+};
+
+} // namespace BlockGame
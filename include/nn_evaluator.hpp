@@ -0,0 +1,112 @@
+#pragma once
+
+#include "evaluator.hpp"
+#include "types.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * Small MLP value network: sparse binary inputs -> H1 (int16 accumulator)
+ * -> clipped ReLU -> H2 (int8 weights) -> clipped ReLU -> scalar (fp32).
+ *
+ * Inputs are the 64 board squares, optionally followed by a "piece type in
+ * hand" one-hot and a "piece type fits somewhere" mask, each with one input per
+ * piece type (NUM_PIECES). Because the inputs are binary, the first layer is just a sum of weight columns for the set
+ * bits, and it can be updated incrementally from the bits that changed between
+ * two positions (NNUE-style). A place() touches a handful of squares and a line
+ * clear 8-15, far fewer than a full refresh of every set square.
+ *
+ * Quantization: layer 1 activations use 127 == 1.0, layer 2 weights 64 == 1.0.
+ * Layer 2 uses AVX2 u8 x i8 dot products when available, with a scalar fallback,
+ * and an fp32 path over dequantized weights is kept for validation.
+ */
+class NNEvaluator : public Evaluator {
+public:
+    static constexpr int BOARD_INPUTS = 64;
+    static constexpr int HAND_INPUTS = NUM_PIECES;
+    static constexpr int FIT_INPUTS = NUM_PIECES;
+    static constexpr int MAX_INPUTS = BOARD_INPUTS + HAND_INPUTS + FIT_INPUTS;
+    static constexpr int SIMD_WIDTH = 32;   // H1 must be a multiple of this
+    static constexpr int MAX_HIDDEN1 = 4096;    // Bounds the layer 1 activation buffers in forward()
+    static constexpr int MAX_HIDDEN2 = 1024;
+
+    enum InputFlags : uint32_t {
+        INPUT_HAND = 1u << 0,
+        INPUT_FIT_MASK = 1u << 1,
+    };
+
+    enum class Precision { INT8, FP32 };
+
+    // Active input features as a bitset, bit i = input i
+    using Features = std::array<uint64_t, (MAX_INPUTS + 63) / 64>;
+
+    /**
+     * First-layer state for one position
+     */
+    struct Accumulator {
+        std::vector<int16_t> values;    // H1 pre-activations
+        Features features{};            // Inputs the values were built from
+    };
+
+    NNEvaluator() = default;
+
+    // Weight file, see save() for the layout. Returns false on a missing or malformed file.
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // Small random network, for testing the plumbing before trained weights exist.
+    // Returns false if the layer sizes exceed MAX_HIDDEN1 / MAX_HIDDEN2.
+    bool initRandom(uint32_t inputFlags, int hidden1, int hidden2, uint64_t seed);
+
+    [[nodiscard]] bool isLoaded() const { return hidden1_ > 0; }
+    [[nodiscard]] uint32_t inputFlags() const { return inputFlags_; }
+
+    void setPrecision(Precision precision) { precision_ = precision; }
+
+    // Evaluator interface. Hand inputs are zero since the next hand is unknown.
+    // Each thread remembers its last accumulator and updates it by the input delta,
+    // so evaluating sibling boards in sequence is incremental.
+    [[nodiscard]] double evaluate(const Board& board) const override;
+
+    // Evaluate with the hand inputs set (pieces[0..count))
+    [[nodiscard]] double evaluate(const Board& board, const PieceType* pieces, int count) const;
+
+    // Batch evaluation; consecutive boards share one incrementally updated accumulator
+    void evaluateBatch(const Board* boards, size_t count, float* out) const;
+
+    // Incremental first layer
+    [[nodiscard]] Features features(const Board& board, const PieceType* pieces = nullptr, int count = 0) const;
+    void refresh(Accumulator& acc, const Features& features) const;
+    // Move acc to the new features by adding/subtracting only the changed columns
+    void update(Accumulator& acc, const Features& features) const;
+    // Output for a prepared accumulator
+    [[nodiscard]] double forward(const Accumulator& acc) const;
+
+private:
+    uint32_t inputFlags_ = 0;
+    int numInputs_ = 0;
+    int hidden1_ = 0;
+    int hidden2_ = 0;
+    Precision precision_ = Precision::INT8;
+
+    std::vector<int16_t> w1_;   // [numInputs][hidden1], column per input
+    std::vector<int16_t> b1_;   // [hidden1]
+    std::vector<int8_t> w2_;    // [hidden2][hidden1]
+    std::vector<int32_t> b2_;   // [hidden2], scale 127 * 64
+    std::vector<float> w3_;     // [hidden2]
+    float b3_ = 0;
+    float outputScale_ = 1;     // Network output units -> score points
+
+    std::vector<float> w2f_;    // Dequantized copy of w2_ for the fp32 path
+    uint64_t weightsId_ = 0;    // Unique per set of weights, keys the per-thread accumulator
+
+    void finishLoad();
+    [[nodiscard]] int inputIndexFit(int piece) const;
+    [[nodiscard]] int inputIndexHand(int piece) const;
+};
+
+} // namespace BlockGame
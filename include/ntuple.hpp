@@ -0,0 +1,83 @@
+#pragma once
+
+#include "evaluator.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * N-tuple network value function.
+ *
+ * Each pattern is a small window of squares (3x3, 2x4, 4x2, a full row or
+ * column) whose occupancy bits index a table of weights. Patterns are shared
+ * across the 8 symmetries of the square (D4): every pattern is expanded into its
+ * rotated and mirrored images, all reading the same table. A lookup is one pext
+ * of the image's squares plus a permutation table load that puts the bits back
+ * into the pattern's canonical order, so evaluating a board is a few dozen loads.
+ *
+ * Pattern specs are "shape:row,col" separated by ';', e.g. "3x3:0,0;2x4:1,0;row:2".
+ * Shapes: 3x3, 2x4 (2 rows x 4 cols), 4x2, row (row index only), col (col index only).
+ */
+class NTupleEvaluator : public Evaluator {
+public:
+    static const char* const DEFAULT_SPEC;
+
+    NTupleEvaluator();
+    // Returns an empty network if spec does not parse; check numPatterns()
+    explicit NTupleEvaluator(const std::string& spec);
+
+    [[nodiscard]] double evaluate(const Board& board) const override;
+
+    // Add delta, split evenly over every lookup, to the weights board reads
+    void update(const Board& board, double delta);
+
+    [[nodiscard]] const std::string& spec() const { return spec_; }
+    [[nodiscard]] size_t numPatterns() const { return patterns_.size(); }
+    [[nodiscard]] size_t numLookups() const { return images_.size(); }
+    [[nodiscard]] size_t numWeights() const { return weights_.size(); }
+
+    // Flat weight storage, exposed for trainers that update weights directly
+    [[nodiscard]] float* weights() { return weights_.data(); }
+
+    // Table slot read for image i of board, as an index into weights()
+    [[nodiscard]] uint32_t lookupIndex(size_t image, uint64_t board) const;
+
+    // Binary file: "BGNT", u32 version, u32 spec length, spec, f32 weights[numWeights]
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+private:
+    struct Pattern {
+        std::vector<int> cells;     // Board bit positions in canonical order
+        uint32_t tableOffset;       // Start of this pattern's table in weights_
+    };
+
+    struct Image {
+        uint64_t mask;              // Squares read by this image
+        uint32_t tableOffset;
+        uint32_t permOffset;        // Start of this image's pext -> canonical index table
+    };
+
+    std::string spec_;
+    std::vector<Pattern> patterns_;
+    std::vector<Image> images_;
+    std::vector<uint16_t> perms_;
+    std::vector<float> weights_;
+
+    bool build(const std::string& spec);
+};
+
+/**
+ * TD(0) self-play training on afterstates.
+ *
+ * A greedy player using the network picks each whole hand; after every hand the
+ * value of the previous afterstate (board after placing a hand) is moved toward
+ * the points earned in the next hand plus the value of the next afterstate, or
+ * just the points if the game ended. Returns the mean score of the training games.
+ */
+double trainTD0(const std::shared_ptr<NTupleEvaluator>& network, int numGames, double alpha, uint64_t seed);
+
+} // namespace BlockGame
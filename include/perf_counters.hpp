@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace BlockGame {
+
+/**
+ * Hardware event counters for the calling thread, via perf_event_open on
+ * Linux. Opening fails gracefully (e.g. no kernel support,
+ * perf_event_paranoid too strict, not Linux); available() then stays false and
+ * every reading is zero, so callers can print "n/a" instead of aborting.
+ *
+ * Each event is opened on its own, so an event the CPU or hypervisor does not
+ * support (cache and TLB events often are not virtualised) is simply missing
+ * from the readings; only cycles are required. When more events are asked for
+ * than the PMU has counters the kernel time-multiplexes them and the readings
+ * are scaled up from the fraction of time each was counted.
+ */
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, BRANCH_MISSES, L1D_MISSES, LLC_MISSES, DTLB_MISSES, NUM_EVENTS };
+
+    static constexpr unsigned eventBit(Event event) { return 1u << event; }
+    static constexpr unsigned ALL_EVENTS = (1u << NUM_EVENTS) - 1;
+    static constexpr unsigned CYCLES_AND_INSTRUCTIONS = (1u << CYCLES) | (1u << INSTRUCTIONS);
+
+    // Short perf-style name, e.g. "branch-misses"
+    static const char* eventName(Event event);
+
+    struct Reading {
+        std::array<uint64_t, NUM_EVENTS> counts{};
+        unsigned valid = 0;     // eventBit() of every event that was counted
+
+        [[nodiscard]] bool has(Event event) const { return valid & eventBit(event); }
+        [[nodiscard]] uint64_t operator[](Event event) const { return counts[event]; }
+        [[nodiscard]] uint64_t cycles() const { return counts[CYCLES]; }
+        [[nodiscard]] uint64_t instructions() const { return counts[INSTRUCTIONS]; }
+        [[nodiscard]] double ipc() const { return cycles() ? static_cast<double>(instructions()) / cycles() : 0.0; }
+
+        // Counts accumulated since an earlier reading of the same counters
+        [[nodiscard]] Reading operator-(const Reading& earlier) const;
+
+        // One line of per-op rates, e.g. "cycles/node 812.3  IPC 2.41  branch-misses/node 1.92 ...",
+        // with "n/a" for events that were not counted
+        [[nodiscard]] std::string describe(double ops, const std::string& unit) const;
+    };
+
+    PerfCounters() = default;
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Returns false, with a reason in error(), if cycles cannot be counted. With inheritThreads
+    // the counts also include threads the calling thread starts after open().
+    bool open(unsigned events = CYCLES_AND_INSTRUCTIONS, bool inheritThreads = false);
+    void close();
+
+    [[nodiscard]] bool available() const { return fds_[CYCLES] >= 0; }
+    [[nodiscard]] bool has(Event event) const { return fds_[event] >= 0; }
+    [[nodiscard]] const std::string& error() const { return error_; }
+
+    // Reset and start counting / stop counting
+    void start();
+    void stop();
+
+    // Counts since start(), scaled if the kernel multiplexed them. May be called while counting.
+    [[nodiscard]] Reading read() const;
+
+private:
+    std::array<int, NUM_EVENTS> fds_ = {-1, -1, -1, -1, -1, -1};
+    std::string error_;
+};
+
+} // namespace BlockGame
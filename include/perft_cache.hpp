@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace BlockGame {
+
+/**
+ * Perft subtree counts kept in a memory-mapped file, keyed by (board,
+ * remaining depth), so later and deeper runs start warm.
+ *
+ * The file is a 64 byte header (magic "BGPC", version, table bits and a
+ * fingerprint of the piece set) followed by 2^bits entries of two 64-bit
+ * words, grouped in buckets of two: the first entry keeps the deepest
+ * subtree stored there (the most work to recompute), the second always takes
+ * the newest one that did not fit. The mapping is shared, so several processes can
+ * use one file at once: like HandCache, the key word is stored XORed with the
+ * data word and a torn entry reads as a miss, never as a wrong count.
+ *
+ * An existing file keeps the size it was created with. One written for a
+ * different piece set is refused rather than reused. Counts of 2^56 or more
+ * are not stored.
+ */
+class PerftCache {
+public:
+    static constexpr int DEFAULT_BITS = 22;             // 64 MiB
+    static constexpr int MIN_BITS = 1;
+    static constexpr int MAX_BITS = 34;                 // 256 GiB
+    static constexpr uint64_t MAX_COUNT = (uint64_t{1} << 56) - 1;
+
+    PerftCache() = default;
+    ~PerftCache();
+
+    PerftCache(const PerftCache&) = delete;
+    PerftCache& operator=(const PerftCache&) = delete;
+
+    // Opens path, creating it with 2^bits entries if it does not exist or is empty.
+    // A file this call created is removed again if it cannot be initialised.
+    // Returns false, with a reason in error(), if the file cannot be used.
+    bool open(const std::string& path, int bits = DEFAULT_BITS);
+    void close();
+
+    [[nodiscard]] bool isOpen() const { return entries_ != nullptr; }
+    [[nodiscard]] const std::string& error() const { return error_; }
+    [[nodiscard]] size_t capacity() const { return isOpen() ? mask_ + 1 : 0; }
+
+    bool probe(uint64_t board, int remaining, uint64_t& count) const;
+    void store(uint64_t board, int remaining, uint64_t count);
+
+    // Entries in use, by scanning the table
+    [[nodiscard]] size_t used() const;
+
+private:
+    void* mapping_ = nullptr;
+    size_t mappedBytes_ = 0;
+    uint64_t* entries_ = nullptr;
+    size_t mask_ = 0;
+    std::string error_;
+
+    [[nodiscard]] size_t bucket(uint64_t board, int remaining) const;
+};
+
+} // namespace BlockGame
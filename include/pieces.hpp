@@ -15,6 +15,8 @@ struct PieceShiftTable {
     std::array<uint64_t, 64> masks;  // Precomputed shifted masks for each position
     int maxRow;                          // Maximum valid row (8 - height)
     int maxCol;                          // Maximum valid col (8 - width)
+    uint64_t originMask;                 // Bit (row * 8 + col) set for every in-bounds origin
+    std::array<uint16_t, 64> lines;      // Board::linesTouched() of each shifted mask, 0 if out of bounds
 };
 
 /**
@@ -47,6 +49,11 @@ struct Piece {
         return shiftTable.masks[row * 8 + col];
     }
 
+    // Rows and columns the piece covers at (row, col), for Board::wouldClear
+    [[nodiscard]] inline uint16_t linesAt(int row, int col) const {
+        return shiftTable.lines[row * 8 + col];
+    }
+
     // Get string representation of piece shape
     [[nodiscard]] std::string toString() const;
 };
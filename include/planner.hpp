@@ -0,0 +1,78 @@
+#pragma once
+
+#include "board.hpp"
+#include "game.hpp"
+#include "hand_cache.hpp"
+#include "statistics.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * A full plan for the rest of a hand: the moves in order and the resulting board
+ */
+struct HandPlan {
+    std::array<Move, Game::HAND_SIZE> moves;
+    int numMoves = 0;
+    Board board;
+    int points = 0;
+};
+
+/**
+ * Whole-hand planner.
+ *
+ * Enumerates every way to place the remaining pieces of a hand, in any order,
+ * breadth first. Each layer is deduplicated on (board, pieces used) keeping the
+ * highest-scoring path, so transpositions from different orderings collapse.
+ * All layers live in flat buffers that are reused between calls.
+ */
+class HandPlanner {
+public:
+    struct Node {
+        uint64_t board;
+        int32_t points;     // Points earned since the start of the hand
+        int32_t parent;     // Index into previous layer, -1 for the root
+        uint8_t used;       // Bitmask of hand slots already placed
+        uint8_t type;       // PieceType of the move that reached this node
+        uint8_t pos;        // row * 8 + col of that move
+    };
+
+    // Expand all placements of pieces[0..count) from board.
+    // Returns the number of pieces that could be placed on the deepest path (0..count).
+    int expand(const Board& board, const PieceType* pieces, int count);
+
+    // Nodes of the deepest reached layer, one per distinct board
+    [[nodiscard]] const std::vector<Node>& leaves() const { return layers_[depth_]; }
+
+    // True if every piece could be placed on at least one path
+    [[nodiscard]] bool complete() const { return depth_ == count_; }
+
+    // Reconstruct the move sequence leading to leaves()[index]
+    [[nodiscard]] HandPlan plan(size_t index) const;
+
+    // Can all of pieces[0..count) be placed? Depth-first with early exit, so much cheaper
+    // than expand() when only the answer is needed. Does not touch leaves(). Placements
+    // that clear lines are tried first, since they free squares for the later pieces.
+    bool feasible(const Board& board, const PieceType* pieces, int count);
+
+    // Move ordering of feasible(): off tries placements in board order, for comparison
+    void setClearingFirst(bool on) { clearingFirst_ = on; }
+    [[nodiscard]] const CutoffHistogram& cutoffs() const { return cutoffs_; }
+    void resetCutoffs() { cutoffs_ = {}; }
+
+    // Share results through cache (nullptr to detach). Not owned. Every expand() stores
+    // whether the hand fits; feasible() reads and fills it too.
+    void setCache(HandCache* cache) { cache_ = cache; }
+
+private:
+    std::array<std::vector<Node>, Game::HAND_SIZE + 1> layers_;
+    int depth_ = 0;
+    int count_ = 0;
+    HandCache* cache_ = nullptr;
+    bool clearingFirst_ = true;
+    CutoffHistogram cutoffs_;
+};
+
+} // namespace BlockGame
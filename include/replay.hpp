@@ -0,0 +1,157 @@
+#pragma once
+
+#include "game.hpp"
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * Binary replay format (little-endian, no alignment requirements).
+ *
+ * File header, 16 bytes:
+ *   char[4] magic "BGRP", u16 version, u16 snapshotInterval, u64 reserved
+ *
+ * Then one block per game:
+ *   u32 blockBytes (whole block including this field)
+ *   u64 seed, i32 finalScore, u32 numTurns, u32 numMoves, u8 strategyId, u8[7] reserved
+ *   numTurns turn records:
+ *     u32 turnWord: bits 0-17 hand (3 x 6-bit PieceType), bits 18-19 placements,
+ *                   bit 20 snapshot present
+ *     [u64 board before the turn, if snapshot present]
+ *     one byte per placement: bits 0-5 position (row * 8 + col), bits 6-7 hand slot
+ *
+ * A typical turn costs 7 bytes. Replaying a block through Game(seed) with the
+ * recorded slots and positions reproduces the game exactly.
+ */
+namespace Replay {
+    constexpr char MAGIC[4] = {'B', 'G', 'R', 'P'};
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t FILE_HEADER_BYTES = 16;
+    constexpr size_t GAME_HEADER_BYTES = 32;
+    constexpr uint32_t SNAPSHOT_BIT = 1u << 20;
+}
+
+/**
+ * Streaming replay writer. Attach to games via the simulation loop's GameRecorder hook.
+ * Each game is assembled in a small scratch buffer, then appended to a large output
+ * buffer that is written out when full.
+ */
+class ReplayWriter : public GameRecorder {
+public:
+    ReplayWriter() = default;
+    ~ReplayWriter() override;
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    // snapshotInterval 0 disables board snapshots, otherwise every Nth turn carries one
+    bool open(const std::string& path, uint8_t strategyId, uint16_t snapshotInterval = 0);
+    bool close();
+
+    void beginGame(uint64_t seed, const Game& game) override;
+    void onHandDrawn(const Game& game) override;
+    void onPlacement(const Game& game, int handIndex, int row, int col, int linesCleared) override;
+    void endGame(const Game& game) override;
+
+private:
+    std::FILE* file_ = nullptr;
+    bool failed_ = false;
+    uint8_t strategyId_ = 0;
+    uint16_t snapshotInterval_ = 0;
+    uint64_t seed_ = 0;
+    uint32_t numTurns_ = 0;
+    uint32_t numMoves_ = 0;
+    size_t turnOffset_ = 0;          // Offset of the current turn word in game_
+    std::vector<uint8_t> game_;      // Current game block
+    std::vector<uint8_t> output_;    // Pending bytes for the file
+
+    void startTurn(const Game& game);
+    void flush();
+};
+
+/**
+ * Decoded turn
+ */
+struct ReplayTurn {
+    std::array<PieceType, Game::HAND_SIZE> hand;
+    int numPlacements;
+    bool hasSnapshot;
+    uint64_t snapshot;                                  // Board before the turn
+    std::array<uint8_t, Game::HAND_SIZE> slots;         // Hand slot of each placement
+    std::array<uint8_t, Game::HAND_SIZE> positions;     // row * 8 + col of each placement
+};
+
+/**
+ * Read-only view of one game block inside a mapped file
+ */
+class ReplayGame {
+public:
+    ReplayGame() = default;
+    ReplayGame(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    [[nodiscard]] uint64_t seed() const;
+    [[nodiscard]] int finalScore() const;
+    [[nodiscard]] uint32_t numTurns() const;
+    [[nodiscard]] uint32_t numMoves() const;
+    [[nodiscard]] uint8_t strategyId() const;
+
+    // Sequential turn decoder, reads straight from the mapping
+    class TurnCursor {
+    public:
+        TurnCursor(const uint8_t* pos, const uint8_t* end) : pos_(pos), end_(end) {}
+        // Returns false at the end of the game or on a truncated record
+        bool next(ReplayTurn& turn);
+
+    private:
+        const uint8_t* pos_;
+        const uint8_t* end_;
+    };
+
+    [[nodiscard]] TurnCursor turns() const {
+        return TurnCursor(data_ + Replay::GAME_HEADER_BYTES, data_ + size_);
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * Memory-mapped replay file reader. Games are handed out as views into the mapping,
+ * nothing is copied.
+ */
+class ReplayReader {
+public:
+    ReplayReader() = default;
+    ~ReplayReader();
+
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    [[nodiscard]] uint16_t snapshotInterval() const { return snapshotInterval_; }
+
+    // Advance to the next game, returns false at end of file or on a corrupt block
+    bool next(ReplayGame& game);
+
+    // Start iterating from the first game again
+    void rewind() { offset_ = Replay::FILE_HEADER_BYTES; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    uint16_t snapshotInterval_ = 0;
+};
+
+// Replay a recorded game through Game and check hands, snapshots and final score.
+// Returns true if everything matches; the replayed score is stored in replayedScore if given.
+bool replayGame(const ReplayGame& recorded, int* replayedScore = nullptr);
+
+} // namespace BlockGame
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "evaluator.hpp"
+#include "record_writer.hpp"
+#include "statistics.hpp"
+#include "strategy.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BlockGame {
+
+// Construct a strategy by name ("random", "greedy", "beam"), nullptr if unknown.
+// evaluator may be null, in which case the default heuristic is used.
+std::unique_ptr<Strategy> makeStrategy(const std::string& name, uint64_t seed, const BeamConfig& beamConfig,
+                                       std::shared_ptr<const Evaluator> evaluator = nullptr);
+
+// Stable numeric id of a strategy name for binary records, -1 if unknown
+int strategyId(const std::string& name);
+
+// Deterministic list of per-game seeds. Two runs with the same seed play the same games.
+std::vector<uint64_t> makeGameSeeds(uint64_t seed, int count);
+
+// Called with every finished game, returns true to end the run early
+using GameCallback = std::function<bool(const GameRecord&)>;
+
+// Play one game per seed, returns the final scores in order
+// recorder, if given, is attached to every game (e.g. a ReplayWriter)
+std::vector<int> runSimulations(Strategy& strategy, const std::vector<uint64_t>& gameSeeds, bool showProgress,
+                                const GameCallback& onGame = {}, GameRecorder* recorder = nullptr);
+
+// Same games as runSimulations(makeGameSeeds(seed, numRuns)) but nothing is stored per game:
+// seeds are generated on the fly and scores go straight into a histogram
+ScoreHistogram streamSimulations(Strategy& strategy, uint64_t seed, uint64_t numRuns, bool showProgress,
+                                 const GameCallback& onGame = {}, GameRecorder* recorder = nullptr);
+
+} // namespace BlockGame
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * Statistics calculator
+ */
+struct Statistics {
+    double min;      // P0
+    double p10;
+    double p25;
+    double median;   // P50
+    double p75;
+    double p90;
+    double max;      // P100
+    double mean;
+    double stddev;
+
+    // Sorts scores in place
+    static Statistics compute(std::vector<int>& scores);
+
+private:
+    static double percentile(const std::vector<int>& sorted, double p);
+};
+
+/**
+ * Exact streaming score distribution.
+ *
+ * Every score is a sum of 8 * lines^2 terms, so scores are multiples of 8 and
+ * one counter per multiple gives exact percentiles in O(max score / 8) memory,
+ * independent of the number of games. Histograms from different threads or
+ * processes combine with merge(), or via save()/load() on disk.
+ */
+class ScoreHistogram {
+public:
+    static constexpr int SCORE_QUANTUM = 8;
+
+    // Returns false, counting nothing, for a score no game can reach:
+    // negative or not a multiple of SCORE_QUANTUM
+    bool add(int score);
+    void merge(const ScoreHistogram& other);
+
+    [[nodiscard]] uint64_t count() const { return count_; }
+
+    // Same definitions as Statistics::compute on the full list of scores
+    [[nodiscard]] Statistics statistics() const;
+
+    // Text format: "count N" then one "score count" line per non-empty bin
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    std::vector<uint64_t> bins_;  // bins_[i] counts score i * SCORE_QUANTUM
+    uint64_t count_ = 0;
+
+    // Score at position rank (0-based) of the sorted list
+    [[nodiscard]] double scoreAtRank(uint64_t rank) const;
+    [[nodiscard]] double percentile(double p) const;
+};
+
+// Two-sided normal quantile for a 95% confidence interval
+constexpr double Z_95 = 1.959963984540054;
+
+/**
+ * Running mean and variance (Welford), O(1) memory and numerically stable.
+ * Used to stop simulations as soon as the answer is known precisely enough.
+ */
+class RunningStats {
+public:
+    void add(double x) {
+        n_++;
+        double delta = x - mean_;
+        mean_ += delta / n_;
+        m2_ += delta * (x - mean_);
+    }
+
+    [[nodiscard]] size_t count() const { return n_; }
+    [[nodiscard]] double mean() const { return mean_; }
+    // Sample variance (n - 1 denominator)
+    [[nodiscard]] double variance() const { return n_ > 1 ? m2_ / (n_ - 1) : 0; }
+    [[nodiscard]] double stdError() const { return n_ > 1 ? std::sqrt(variance() / n_) : 0; }
+    // Half-width of the confidence interval on the mean
+    [[nodiscard]] double ciHalfWidth(double z = Z_95) const { return z * stdError(); }
+
+private:
+    size_t n_ = 0;
+    double mean_ = 0;
+    double m2_ = 0;
+};
+
+/**
+ * Paired comparison of two strategies that played the same games.
+ * Differences are taken game by game, so the shared hand luck cancels out.
+ */
+struct PairedStatistics {
+    size_t n;
+    double meanDiff;     // mean(candidate - baseline)
+    double stddevDiff;   // Sample standard deviation of the differences
+    double stdError;     // stddevDiff / sqrt(n)
+    double ciLow;        // meanDiff -/+ z * stdError
+    double ciHigh;
+    double correlation;  // Pearson correlation of the two score lists
+
+    // candidate[i] and baseline[i] must come from the same game seed
+    static PairedStatistics compute(const std::vector<int>& candidate, const std::vector<int>& baseline,
+                                    double z = Z_95);
+};
+
+/**
+ * Move-ordering statistics of a depth-first search that stops at the first
+ * success. Every node that succeeds records its cutoff index, the number of
+ * moves tried before the one that worked (0 = the first), and whether that
+ * move cleared lines; nodes where every move failed are counted apart, since
+ * no ordering makes them cheaper. A good ordering piles the histogram into
+ * index 0.
+ */
+class CutoffHistogram {
+public:
+    static constexpr int BUCKETS = 16;      // The last bucket also holds every later index
+
+    void cutoff(int index, bool clearing) {
+        counts_[index < BUCKETS ? index : BUCKETS - 1]++;
+        cutoffs_++;
+        indexSum_ += static_cast<uint64_t>(index);
+        clearingCutoffs_ += clearing;
+    }
+    void exhausted() { exhausted_++; }
+    void merge(const CutoffHistogram& other);
+
+    [[nodiscard]] uint64_t cutoffs() const { return cutoffs_; }
+    [[nodiscard]] uint64_t exhaustedNodes() const { return exhausted_; }
+    [[nodiscard]] uint64_t clearingCutoffs() const { return clearingCutoffs_; }
+    [[nodiscard]] uint64_t count(int index) const { return counts_[index]; }
+    [[nodiscard]] double meanIndex() const { return cutoffs_ ? static_cast<double>(indexSum_) / cutoffs_ : 0; }
+
+    // Summary line plus the share of cutoffs at each index, for printing
+    [[nodiscard]] std::string describe() const;
+
+private:
+    std::array<uint64_t, BUCKETS> counts_{};
+    uint64_t cutoffs_ = 0;
+    uint64_t exhausted_ = 0;
+    uint64_t clearingCutoffs_ = 0;
+    uint64_t indexSum_ = 0;
+};
+
+} // namespace BlockGame
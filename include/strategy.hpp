@@ -0,0 +1,123 @@
+#pragma once
+
+#include "evaluator.hpp"
+#include "game.hpp"
+#include "planner.hpp"
+#include "thread_pool.hpp"
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * A strategy decides how to place the pieces of the current hand
+ */
+class Strategy {
+public:
+    virtual ~Strategy() = default;
+
+    [[nodiscard]] virtual std::string name() const = 0;
+
+    // Place pieces from the current hand until a new hand is drawn or the game ends
+    virtual void playTurn(Game& game) = 0;
+
+    // Play until the game is over, returns final score
+    int playGame(Game& game);
+
+    // Share whole-hand feasibility results between the strategy's planners and the games it
+    // plays (nullptr to detach). Not owned; must outlive the strategy's use of it.
+    virtual void setHandCache(HandCache* cache) { handCache_ = cache; }
+
+protected:
+    HandCache* handCache_ = nullptr;
+};
+
+// Collect the pieces of the hand that have not been placed yet, returns how many
+int remainingPieces(const Game& game, PieceType* out);
+
+/**
+ * Simple strategy: pick a random legal move for any available piece
+ */
+class RandomStrategy : public Strategy {
+public:
+    explicit RandomStrategy(uint64_t seed) : rng_(seed) {}
+
+    [[nodiscard]] std::string name() const override { return "random"; }
+    void playTurn(Game& game) override;
+
+private:
+    std::mt19937_64 rng_;
+};
+
+/**
+ * Plays the whole hand that maximizes points earned plus the evaluation of the final board
+ */
+class GreedyStrategy : public Strategy {
+public:
+    explicit GreedyStrategy(std::shared_ptr<const Evaluator> evaluator) : evaluator_(std::move(evaluator)) {}
+
+    [[nodiscard]] std::string name() const override { return "greedy"; }
+    void playTurn(Game& game) override;
+    void setHandCache(HandCache* cache) override;
+
+private:
+    std::shared_ptr<const Evaluator> evaluator_;
+    HandPlanner planner_;
+};
+
+struct BeamConfig {
+    int width = 8;              // Boards kept after each hand
+    int depth = 2;              // Hands searched, including the current one
+    int samples = 4;            // Sampled future hand sequences averaged per decision
+    int threads = 0;            // Worker threads for expansion, 0 = all cores
+    double deathPenalty = 1e4;  // Subtracted from lines that cannot place a full hand
+};
+
+/**
+ * Beam search over future hands.
+ *
+ * The current hand is expanded exactly. The best `width` resulting boards seed a
+ * beam that is pushed through `depth - 1` sampled future hands; after each hand
+ * only the top `width` distinct boards survive. Every beam entry remembers which
+ * root board it descends from, and the root with the best average final value
+ * over `samples` sampled hand sequences is played.
+ */
+class BeamStrategy : public Strategy {
+public:
+    BeamStrategy(std::shared_ptr<const Evaluator> evaluator, const BeamConfig& config, uint64_t seed);
+
+    [[nodiscard]] std::string name() const override { return "beam"; }
+    void playTurn(Game& game) override;
+    void setHandCache(HandCache* cache) override;
+
+    [[nodiscard]] const BeamConfig& config() const { return config_; }
+
+private:
+    struct Entry {
+        uint64_t board;
+        double value;       // points + evaluation, or points - deathPenalty when dead
+        int32_t points;     // Points earned since the root hand
+        int32_t root;       // Index of the root leaf this line started from
+        bool alive;
+    };
+
+    std::shared_ptr<const Evaluator> evaluator_;
+    BeamConfig config_;
+    std::mt19937_64 rng_;
+    ThreadPool pool_;
+
+    HandPlanner rootPlanner_;
+    std::vector<HandPlanner> planners_;             // One per worker
+    std::vector<std::vector<Entry>> workerOutput_;  // One per worker
+    std::vector<double> rootValues_;
+    std::vector<Entry> beam_;
+    std::vector<Entry> next_;
+    std::vector<double> totals_;
+
+    void searchScenario(const std::vector<Entry>& roots);
+    void selectTop(std::vector<Entry>& entries) const;
+};
+
+} // namespace BlockGame
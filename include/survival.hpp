@@ -0,0 +1,97 @@
+#pragma once
+
+#include "evaluator.hpp"
+#include "pieces.hpp"
+#include "statistics.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace BlockGame {
+
+struct SurvivalEstimate {
+    double probability = 0;         // Chance the next random hand can be placed in full
+    double lower = 0;               // 95% confidence bounds, equal to probability when exact
+    double upper = 0;
+    double multisetFraction = -1;   // Fraction of distinct hand multisets that fit, exact mode only
+    uint64_t handsChecked = 0;
+};
+
+/**
+ * Probability that a board can take a whole random hand.
+ *
+ * exact() checks all C(NUM_PIECES + 2, 3) hand multisets, each weighted by the
+ * number of ordered hands it stands for. Fit masks of every piece are computed
+ * once per board; a hand with a piece that fits nowhere fails immediately unless
+ * one of its pieces can clear a line first. Otherwise the search is depth-first
+ * and stops at the first ordering that places all three pieces, with the answer
+ * for (board, last two pieces) cached since the same pair is asked for again
+ * from every placement of the first piece. Placements that clear lines are
+ * tried first: they are the ones that make room for the rest of the hand.
+ *
+ * sampled() checks random ordered hands drawn like Game draws them and reports
+ * the fraction that fit, bounded by a Wilson score interval. With the same seed every board is checked against
+ * the same hands, so comparisons between boards are not drowned by sampling noise.
+ */
+class SurvivalEstimator {
+public:
+    // cacheBits: log2 of the number of (board, pair) cache slots
+    explicit SurvivalEstimator(int cacheBits = 16) : pairCache_(size_t{1} << cacheBits) {}
+
+    SurvivalEstimate exact(const Board& board);
+    SurvivalEstimate sampled(const Board& board, int samples, uint64_t seed);
+
+    // True if the three pieces can all be placed on board in some order
+    bool canPlaceHand(const Board& board, PieceType a, PieceType b, PieceType c);
+
+    // Move ordering of the search: off tries placements in board order, for comparison
+    void setClearingFirst(bool on) { clearingFirst_ = on; }
+    [[nodiscard]] const CutoffHistogram& cutoffs() const { return cutoffs_; }
+
+private:
+    // Direct-mapped: a colliding entry simply replaces the old one
+    struct PairEntry {
+        uint64_t board;
+        uint16_t pieces;    // smaller * NUM_PIECES + larger + 1, 0 for an empty slot
+        bool result;
+    };
+
+    std::vector<PairEntry> pairCache_;
+
+    // Per-board state, refreshed when a different board is asked about
+    uint64_t board_ = ~0ULL;
+    bool boardValid_ = false;
+    std::array<uint64_t, NUM_PIECES> fits_{};
+    std::array<int8_t, NUM_PIECES> canClear_{};     // -1 unknown, 0 no, 1 yes
+    int minToClear_ = 0;                            // Fewest empty squares in a row or column
+
+    bool clearingFirst_ = true;
+    CutoffHistogram cutoffs_;
+
+    void prepare(uint64_t board);
+    bool canClear(int type);
+    bool canPlacePair(uint64_t board, int x, int y);
+    [[nodiscard]] uint64_t clearingFits(const Board& board, const Piece& piece, uint64_t fits) const {
+        return clearingFirst_ ? board.clearingFits(piece, fits) : 0;
+    }
+};
+
+/**
+ * Adds weight * survival probability to a base evaluation.
+ * samples > 0 uses the sampled estimate with a fixed hand set; 0 is exact.
+ */
+class SurvivalEvaluator : public Evaluator {
+public:
+    SurvivalEvaluator(std::shared_ptr<const Evaluator> base, double weight, int samples)
+        : base_(std::move(base)), weight_(weight), samples_(samples) {}
+
+    [[nodiscard]] double evaluate(const Board& board) const override;
+
+private:
+    std::shared_ptr<const Evaluator> base_;
+    double weight_;
+    int samples_;
+};
+
+} // namespace BlockGame
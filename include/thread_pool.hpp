@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BlockGame {
+
+/**
+ * Fixed-size pool of worker threads for data-parallel loops.
+ * Workers are created once and parked between calls, so parallelFor can be
+ * invoked every turn without paying thread start-up costs.
+ */
+class ThreadPool {
+public:
+    // numThreads <= 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(int numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] int size() const { return numThreads_; }
+
+    // Run fn(index, worker) for every index in [0, count). Blocks until all are done.
+    // worker is in [0, size()) and can be used to select per-thread scratch buffers.
+    void parallelFor(size_t count, const std::function<void(size_t, int)>& fn);
+
+private:
+    int numThreads_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t, int)>* job_ = nullptr;
+    size_t jobCount_ = 0;
+    size_t nextIndex_ = 0;
+    int activeWorkers_ = 0;
+    uint64_t generation_ = 0;
+    bool stopping_ = false;
+
+    void workerLoop(int worker);
+    void runJob(int worker);
+};
+
+} // namespace BlockGame
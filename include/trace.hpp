@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+// Configure with -DBLOCKGAME_TRACE=ON to compile the trace points in. When off
+// the macros below expand to nothing and their arguments are not evaluated.
+#ifndef BLOCKGAME_TRACE
+#define BLOCKGAME_TRACE 0
+#endif
+
+namespace BlockGame {
+
+/**
+ * Hot-path tracing: scoped timers and event counters at named sites.
+ *
+ * Each thread accumulates calls, time and counts per site into its own table,
+ * with no locking after the thread's first event. The tables are merged when
+ * the program exits and a summary, sorted by total time, is written to
+ * stderr. Timer times are inclusive, so a site nested inside another is
+ * counted in both.
+ *
+ * If BLOCKGAME_TRACE_JSON names a file, every timed scope is also kept as a
+ * Chrome trace event ("ph":"X") and the file is written at exit, for viewing
+ * in chrome://tracing or Perfetto. At most MAX_EVENTS_PER_THREAD are kept per
+ * thread; later ones still count in the summary.
+ */
+class Trace {
+public:
+    static constexpr bool ENABLED = BLOCKGAME_TRACE != 0;
+    static constexpr uint64_t MAX_EVENTS_PER_THREAD = uint64_t{1} << 20;
+
+    // Id of a named site; name must outlive the program (a string literal)
+    static int site(const char* name);
+
+    // Monotonic clock in nanoseconds
+    static uint64_t now();
+
+    static void record(int site, uint64_t start, uint64_t duration);
+    static void count(int site, uint64_t n);
+};
+
+/**
+ * Times its own lifetime into a trace site
+ */
+class TraceScope {
+public:
+    explicit TraceScope(int site) : site_(site), start_(Trace::now()) {}
+    ~TraceScope() { Trace::record(site_, start_, Trace::now() - start_); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    int site_;
+    uint64_t start_;
+};
+
+} // namespace BlockGame
+
+#define BG_TRACE_CONCAT_INNER(a, b) a##b
+#define BG_TRACE_CONCAT(a, b) BG_TRACE_CONCAT_INNER(a, b)
+
+#if BLOCKGAME_TRACE
+
+// Time the rest of the enclosing scope
+#define BG_TRACE_SCOPE(name)                                                                              \
+    static const int BG_TRACE_CONCAT(bgTraceSite, __LINE__) = ::BlockGame::Trace::site(name);            \
+    ::BlockGame::TraceScope BG_TRACE_CONCAT(bgTraceScope, __LINE__)(BG_TRACE_CONCAT(bgTraceSite, __LINE__))
+
+// Add n to a counter
+#define BG_TRACE_COUNT(name, n)                                                                           \
+    do {                                                                                                  \
+        static const int bgTraceSite = ::BlockGame::Trace::site(name);                                    \
+        ::BlockGame::Trace::count(bgTraceSite, static_cast<uint64_t>(n));                                 \
+    } while (0)
+
+#else
+
+#define BG_TRACE_SCOPE(name) static_assert(true, "")
+#define BG_TRACE_COUNT(name, n) \
+    do {                        \
+    } while (0)
+
+#endif
@@ -0,0 +1,465 @@
+#include "bench_history.hpp"
+#include "board.hpp"
+#include "game.hpp"
+#include "perf_counters.hpp"
+#include "pieces.hpp"
+#include "strategy.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace BlockGame;
+
+/**
+ * Microbenchmarks for the engine primitives.
+ *
+ * Every benchmark runs a fixed number of operations over seeded board corpora
+ * of controlled density, so two runs with the same seed execute exactly the
+ * same work. Each is repeated and the median repetition is reported; rows are
+ * always printed in the same order with fixed-width columns so the output of
+ * two commits can be diffed directly.
+ *
+ * With --history the results are also appended to a JSON Lines file along
+ * with the git commit and CPU model, and compared with the last runs on the
+ * same CPU; significant slowdowns are listed and make the exit status 1.
+ */
+
+namespace {
+
+constexpr size_t CORPUS_SIZE = 4096;
+constexpr int DENSITIES[] = {20, 50, 80};   // Percent of squares filled
+
+struct Benchmark {
+    std::string name;
+    uint64_t ops;                           // Operations per repetition
+    std::function<uint64_t()> run;          // Returns a checksum so the work cannot be optimised away
+    std::string unit = "ns/op";             // Unit recorded in the history: "ns/op" or a rate per second
+};
+
+struct Result {
+    double nsPerOp;
+    double cyclesPerOp;
+    double ipc;
+};
+
+struct BenchConfig {
+    std::string filter;
+    int repeat = 5;
+    double scale = 1.0;
+    uint64_t seed = 1;
+    bool list = false;
+    std::string historyPath;
+    std::string commit;                     // Defaults to the git commit of the working directory
+    int baselineRuns = 5;
+    double threshold = 0.05;                // Minimum relative slowdown to flag
+    bool record = true;
+};
+
+// Random boards with each square filled with the given probability. One board in
+// four also gets a full row or column, so line clearing has work to do.
+std::vector<Board> makeCorpus(int densityPercent, uint64_t seed) {
+    std::mt19937_64 rng(seed * 1000 + densityPercent);
+    std::bernoulli_distribution filled(densityPercent / 100.0);
+    std::uniform_int_distribution<int> line(0, 15);
+    std::vector<Board> corpus;
+    corpus.reserve(CORPUS_SIZE);
+    for (size_t i = 0; i < CORPUS_SIZE; ++i) {
+        uint64_t bits = 0;
+        for (int sq = 0; sq < 64; ++sq) {
+            if (filled(rng)) bits |= 1ULL << sq;
+        }
+        if (i % 4 == 0) {
+            const int l = line(rng);
+            bits |= l < 8 ? Board::rowMask(l) : Board::colMask(l - 8);
+        }
+        corpus.push_back(Board(bits));
+    }
+    return corpus;
+}
+
+// Piece display names have spaces and degree signs; keep names to one ASCII token
+std::string benchName(const std::string& name) {
+    std::string out;
+    for (char ch : name) {
+        const bool keep = (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+        if (keep) {
+            out += ch;
+        } else if (!out.empty() && out.back() != '_') {
+            out += '_';
+        }
+    }
+    while (!out.empty() && out.back() == '_') out.pop_back();
+    return out;
+}
+
+// Leaf count of the full move tree, perft's move loop without the transposition
+// table so the time goes into move generation rather than hashing
+uint64_t perftLeaves(const Board& board, int depth, const std::vector<Piece>& pieces) {
+    if (depth == 0) return 1;
+    uint64_t leaves = 0;
+    for (const auto& piece : pieces) {
+        for (int row = 0; row < piece.shiftTable.maxRow + 1; ++row) {
+            for (int col = 0; col < piece.shiftTable.maxCol + 1; ++col) {
+                const uint64_t mask = piece.shiftToUnsafe(row, col);
+                if (board.canPlace(mask)) {
+                    Board next = board;
+                    next.placeAndClear(mask);
+                    leaves += perftLeaves(next, depth - 1, pieces);
+                }
+            }
+        }
+    }
+    return leaves ? leaves : 1;
+}
+
+// Value stored in the history for a benchmark measured at nsPerOp
+double metricValue(const Benchmark& bench, const Result& r) {
+    return bench.unit == "ns/op" ? r.nsPerOp : 1e9 / r.nsPerOp;
+}
+
+Result measure(const Benchmark& bench, int repeat, PerfCounters& counters, uint64_t& checksum) {
+    std::vector<Result> results;
+    checksum += bench.run();    // Warm-up
+    for (int r = 0; r < repeat; ++r) {
+        counters.start();
+        auto start = std::chrono::steady_clock::now();
+        checksum += bench.run();
+        auto end = std::chrono::steady_clock::now();
+        counters.stop();
+
+        const PerfCounters::Reading reading = counters.read();
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        results.push_back({ns / bench.ops, static_cast<double>(reading.cycles()) / bench.ops, reading.ipc()});
+    }
+    std::sort(results.begin(), results.end(), [](const Result& a, const Result& b) { return a.nsPerOp < b.nsPerOp; });
+    return results[results.size() / 2];
+}
+
+void printUsage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n";
+    std::cerr << "  --filter TEXT  Only run benchmarks whose name contains TEXT\n";
+    std::cerr << "  --repeat N     Timed repetitions per benchmark, median reported (default: 5)\n";
+    std::cerr << "  --scale F      Multiply the operations per repetition (default: 1)\n";
+    std::cerr << "  --seed N       Seed for the board corpora and games (default: 1)\n";
+    std::cerr << "  --list         List benchmark names and exit\n";
+    std::cerr << "  --history FILE Record the results in a JSON Lines history and compare them with\n";
+    std::cerr << "                 earlier runs on the same CPU; exit status 1 on a regression\n";
+    std::cerr << "  --baseline-runs N  Earlier runs to compare with (default: 5)\n";
+    std::cerr << "  --threshold PCT    Smallest slowdown reported as a regression (default: 5)\n";
+    std::cerr << "  --commit ID    Commit recorded with the run (default: git describe of the working tree)\n";
+    std::cerr << "  --no-record    Compare with the history without appending this run\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--list") {
+            config.list = true;
+            continue;
+        } else if (arg == "--no-record") {
+            config.record = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--filter") {
+                config.filter = value;
+            } else if (arg == "--repeat") {
+                config.repeat = std::max(1, std::stoi(value));
+            } else if (arg == "--scale") {
+                config.scale = std::stod(value);
+            } else if (arg == "--seed") {
+                config.seed = std::stoull(value);
+            } else if (arg == "--history") {
+                config.historyPath = value;
+            } else if (arg == "--baseline-runs") {
+                config.baselineRuns = std::max(1, std::stoi(value));
+            } else if (arg == "--threshold") {
+                config.threshold = std::stod(value) / 100.0;
+            } else if (arg == "--commit") {
+                config.commit = value;
+            } else {
+                std::cerr << "Error: unknown option " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    auto scaled = [&](uint64_t passes) {
+        return std::max<uint64_t>(1, static_cast<uint64_t>(passes * config.scale));
+    };
+
+    std::vector<std::vector<Board>> corpora;
+    for (int density : DENSITIES) {
+        corpora.push_back(makeCorpus(density, config.seed));
+    }
+
+    // Per-board placement queries: a piece and an in-bounds origin
+    struct Query {
+        PieceType type;
+        int row;
+        int col;
+    };
+    std::vector<Query> queries(CORPUS_SIZE);
+    {
+        std::mt19937_64 rng(config.seed);
+        for (auto& q : queries) {
+            q.type = static_cast<PieceType>(rng() % NUM_PIECES);
+            const Piece& piece = getPiece(q.type);
+            q.row = static_cast<int>(rng() % (piece.shiftTable.maxRow + 1));
+            q.col = static_cast<int>(rng() % (piece.shiftTable.maxCol + 1));
+        }
+    }
+
+    // A legal move per board for makeMove, boards where nothing fits are skipped
+    struct MoveCase {
+        Board board;
+        Move move;
+    };
+    std::vector<std::vector<MoveCase>> moveCases(corpora.size());
+    for (size_t d = 0; d < corpora.size(); ++d) {
+        std::mt19937_64 rng(config.seed + d);
+        for (const Board& board : corpora[d]) {
+            for (int attempt = 0; attempt < NUM_PIECES; ++attempt) {
+                const auto moves = board.getLegalMoves(static_cast<PieceType>(rng() % NUM_PIECES));
+                if (!moves.empty()) {
+                    moveCases[d].push_back({board, moves[rng() % moves.size()]});
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<Benchmark> benchmarks;
+    for (size_t d = 0; d < corpora.size(); ++d) {
+        const std::string suffix = "/d" + std::to_string(DENSITIES[d]);
+        const auto& corpus = corpora[d];
+
+        const uint64_t linePasses = scaled(256);
+        benchmarks.push_back({"clearFullLines" + suffix, linePasses * CORPUS_SIZE, [&corpus, linePasses] {
+            uint64_t sum = 0;
+            for (uint64_t p = 0; p < linePasses; ++p) {
+                for (const Board& board : corpus) {
+                    Board b = board;
+                    sum += b.clearFullLines();
+                }
+            }
+            return sum;
+        }});
+
+        const uint64_t placePasses = scaled(256);
+        benchmarks.push_back({"canPlace" + suffix, placePasses * CORPUS_SIZE, [&corpus, &queries, placePasses] {
+            uint64_t sum = 0;
+            for (uint64_t p = 0; p < placePasses; ++p) {
+                for (size_t i = 0; i < CORPUS_SIZE; ++i) {
+                    sum += corpus[i].canPlacePiece(queries[i].type, queries[i].row, queries[i].col);
+                }
+            }
+            return sum;
+        }});
+
+        const uint64_t countPasses = scaled(32);
+        benchmarks.push_back({"countValidPlacements" + suffix, countPasses * CORPUS_SIZE, [&corpus, countPasses] {
+            uint64_t sum = 0;
+            for (uint64_t p = 0; p < countPasses; ++p) {
+                for (size_t i = 0; i < CORPUS_SIZE; ++i) {
+                    sum += corpus[i].countValidPlacements(static_cast<PieceType>((i + p) % NUM_PIECES));
+                }
+            }
+            return sum;
+        }});
+
+        // Includes restoring the board and hand before each move
+        const auto& cases = moveCases[d];
+        const uint64_t movePasses = scaled(64);
+        benchmarks.push_back({"makeMove" + suffix, movePasses * cases.size(), [&cases, movePasses] {
+            Game game(1);
+            uint64_t sum = 0;
+            for (uint64_t p = 0; p < movePasses; ++p) {
+                for (const MoveCase& c : cases) {
+                    game.board_ = c.board;
+                    game.gameOver_ = false;
+                    game.hand_[0] = c.move.type;
+                    game.handUsed_ = {false, true, true};
+                    sum += game.makeMove(c.move, false);
+                }
+            }
+            return sum + game.board().data();
+        }});
+
+        // Draw plus the game-over scan of the new hand
+        const uint64_t drawPasses = scaled(64);
+        benchmarks.push_back({"drawHand" + suffix, drawPasses * CORPUS_SIZE, [&corpus, drawPasses] {
+            Game game(1);
+            uint64_t sum = 0;
+            for (uint64_t p = 0; p < drawPasses; ++p) {
+                for (const Board& board : corpus) {
+                    game.board_ = board;
+                    game.gameOver_ = false;
+                    game.drawHand();
+                    sum += game.isGameOver() + game.hand()[0];
+                }
+            }
+            return sum;
+        }});
+    }
+
+    // Move generation for each piece on the medium density corpus
+    const auto& mid = corpora[1];
+    for (int type = 0; type < NUM_PIECES; ++type) {
+        const uint64_t passes = scaled(16);
+        benchmarks.push_back({"getLegalMoves/" + benchName(getPiece(static_cast<PieceType>(type)).name), passes * CORPUS_SIZE,
+                              [&mid, type, passes] {
+            uint64_t sum = 0;
+            for (uint64_t p = 0; p < passes; ++p) {
+                for (const Board& board : mid) {
+                    sum += board.getLegalMoves(static_cast<PieceType>(type)).size();
+                }
+            }
+            return sum;
+        }});
+    }
+
+    // Whole games with uniformly random legal moves; an op is one game
+    const uint64_t numGames = scaled(512);
+    const uint64_t gameSeed = config.seed;
+    benchmarks.push_back({"randomGame", numGames, [numGames, gameSeed] {
+        std::mt19937_64 rng(gameSeed);
+        uint64_t sum = 0;
+        for (uint64_t g = 0; g < numGames; ++g) {
+            Game game(rng());
+            while (!game.isGameOver()) {
+                const auto moves = game.getAllLegalMoves();
+                if (moves.empty()) break;
+                game.makeMove(moves[rng() % moves.size()]);
+            }
+            sum += game.score();
+        }
+        return sum;
+    }});
+
+    // Whole-tree enumeration like perft; an op is one leaf
+    const auto& pieces = getAllPieces();
+    Board nearFull;
+    for (int r = 1; r <= 6; ++r) {
+        for (int c = 1; c <= 6; ++c) nearFull.setOccupied(r, c);
+    }
+    const struct {
+        const char* name;
+        Board board;
+        int depth;
+    } perftCases[] = {{"perft/default/d2", Board(), 2}, {"perft/nearfull/d3", nearFull, 3}};
+    for (const auto& pc : perftCases) {
+        const uint64_t leaves = perftLeaves(pc.board, pc.depth, pieces);
+        const uint64_t passes = scaled(1);
+        benchmarks.push_back({pc.name, passes * leaves, [&pieces, board = pc.board, depth = pc.depth, passes] {
+            uint64_t sum = 0;
+            for (uint64_t p = 0; p < passes; ++p) sum += perftLeaves(board, depth, pieces);
+            return sum;
+        }, "nodes/s"});
+    }
+
+    // Simulator throughput with the greedy strategy and default heuristic; an op is one game
+    const uint64_t greedyGames = scaled(8);
+    benchmarks.push_back({"simulate/greedy", greedyGames, [greedyGames, gameSeed] {
+        GreedyStrategy strategy(std::make_shared<HeuristicEvaluator>());
+        std::mt19937_64 rng(gameSeed);
+        uint64_t sum = 0;
+        for (uint64_t g = 0; g < greedyGames; ++g) {
+            Game game(rng());
+            sum += strategy.playGame(game);
+        }
+        return sum;
+    }, "games/s"});
+
+    if (config.list) {
+        for (const auto& bench : benchmarks) std::cout << bench.name << "\n";
+        return 0;
+    }
+
+    PerfCounters counters;
+    const bool haveCounters = counters.open();
+
+    std::printf("# bench seed=%llu repeat=%d scale=%g corpus=%zu\n", static_cast<unsigned long long>(config.seed),
+                config.repeat, config.scale, CORPUS_SIZE);
+    if (!haveCounters) {
+        std::printf("# cycles/IPC unavailable (%s)\n", counters.error().c_str());
+    }
+    std::printf("%-36s %12s %12s %8s %12s\n", "benchmark", "ns/op", "cycles/op", "IPC", "ops");
+
+    BenchRun run;
+    run.commit = config.commit.empty() ? currentCommit() : config.commit;
+    run.cpu = cpuModel();
+    run.time = utcTimestamp();
+    run.seed = config.seed;
+    run.scale = config.scale;
+    run.repeat = config.repeat;
+
+    uint64_t checksum = 0;
+    for (const auto& bench : benchmarks) {
+        if (!config.filter.empty() && bench.name.find(config.filter) == std::string::npos) continue;
+        const Result r = measure(bench, config.repeat, counters, checksum);
+        run.metrics.push_back({bench.name, bench.unit, metricValue(bench, r)});
+        if (haveCounters) {
+            std::printf("%-36s %12.2f %12.2f %8.2f %12llu\n", bench.name.c_str(), r.nsPerOp, r.cyclesPerOp, r.ipc,
+                        static_cast<unsigned long long>(bench.ops));
+        } else {
+            std::printf("%-36s %12.2f %12s %8s %12llu\n", bench.name.c_str(), r.nsPerOp, "n/a", "n/a",
+                        static_cast<unsigned long long>(bench.ops));
+        }
+        std::fflush(stdout);
+    }
+    std::printf("# checksum %llu\n", static_cast<unsigned long long>(checksum));
+
+    if (config.historyPath.empty()) return 0;
+
+    BenchHistory history;
+    if (!history.load(config.historyPath)) {
+        std::cerr << "Error: cannot read history " << config.historyPath << "\n";
+        return 1;
+    }
+    const auto comparisons = history.compare(run, config.baselineRuns, config.threshold);
+    const size_t baselineSize = history.baseline(run, config.baselineRuns).size();
+
+    std::printf("\n# history %s: commit %s, cpu \"%s\", %zu comparable earlier run(s)\n", config.historyPath.c_str(),
+                run.commit.c_str(), run.cpu.c_str(), baselineSize);
+    int regressions = 0;
+    if (baselineSize < BenchHistory::MIN_BASELINE_RUNS) {
+        std::printf("# need at least %zu earlier runs to test for regressions\n", BenchHistory::MIN_BASELINE_RUNS);
+    } else {
+        std::printf("%-36s %9s %14s %14s %12s %8s\n", "benchmark", "unit", "value", "baseline", "stddev", "change");
+        for (const auto& c : comparisons) {
+            if (c.baselineRuns == 0) continue;
+            std::printf("%-36s %9s %14.6g %14.6g %12.4g %+7.1f%%%s\n", c.metric.name.c_str(), c.metric.unit.c_str(),
+                        c.metric.value, c.baselineMean, c.baselineStddev, 100.0 * c.change,
+                        c.regression ? "  REGRESSION" : "");
+            regressions += c.regression;
+        }
+        std::printf("# %d regression(s) at threshold %.1f%%\n", regressions, 100.0 * config.threshold);
+    }
+
+    if (config.record && !BenchHistory::append(config.historyPath, run)) {
+        std::cerr << "Error: cannot append to " << config.historyPath << "\n";
+        return 1;
+    }
+    return regressions > 0 ? 1 : 0;
+}
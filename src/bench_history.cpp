@@ -0,0 +1,334 @@
+#include "bench_history.hpp"
+#include "statistics.hpp"
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+
+namespace BlockGame {
+
+namespace {
+
+// Two-sided 95% Student t quantiles for 1..30 degrees of freedom
+constexpr double T_95[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                           2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                           2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+double tQuantile95(size_t degreesOfFreedom) {
+    if (degreesOfFreedom == 0) return 0;
+    if (degreesOfFreedom <= std::size(T_95)) return T_95[degreesOfFreedom - 1];
+    return Z_95;
+}
+
+std::string quote(const std::string& s) {
+    std::string out = "\"";
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\') {
+            out += '\\';
+            out += ch;
+        } else if (static_cast<unsigned char>(ch) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            out += buf;
+        } else {
+            out += ch;
+        }
+    }
+    return out + "\"";
+}
+
+std::string number(double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", value);
+    return buf;
+}
+
+/**
+ * Just enough JSON to read back what append() writes: objects, strings and
+ * numbers. Unknown keys are ignored so fields can be added later.
+ */
+class JsonReader {
+public:
+    explicit JsonReader(const std::string& text) : text_(text) {}
+
+    bool readRun(BenchRun& run) {
+        bool ok = object([&](const std::string& key) {
+            if (key == "commit") return stringValue(run.commit);
+            if (key == "cpu") return stringValue(run.cpu);
+            if (key == "time") return stringValue(run.time);
+            if (key == "seed") return unsignedValue(run.seed);
+            if (key == "scale") return numberValue(run.scale);
+            if (key == "repeat") {
+                double v;
+                if (!numberValue(v)) return false;
+                run.repeat = static_cast<int>(v);
+                return true;
+            }
+            if (key == "metrics") {
+                return object([&](const std::string& name) {
+                    BenchMetric metric;
+                    metric.name = name;
+                    bool parsed = object([&](const std::string& field) {
+                        if (field == "value") return numberValue(metric.value);
+                        if (field == "unit") return stringValue(metric.unit);
+                        return skipValue();
+                    });
+                    if (parsed) run.metrics.push_back(metric);
+                    return parsed;
+                });
+            }
+            return skipValue();
+        });
+        skipSpace();
+        return ok && pos_ == text_.size();
+    }
+
+private:
+    const std::string& text_;
+    size_t pos_ = 0;
+
+    void skipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+    }
+
+    bool expect(char ch) {
+        skipSpace();
+        if (pos_ >= text_.size() || text_[pos_] != ch) return false;
+        ++pos_;
+        return true;
+    }
+
+    template <typename OnMember>
+    bool object(OnMember onMember) {
+        if (!expect('{')) return false;
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == '}') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            std::string key;
+            if (!stringValue(key) || !expect(':') || !onMember(key)) return false;
+            if (expect(',')) continue;
+            return expect('}');
+        }
+    }
+
+    bool stringValue(std::string& out) {
+        if (!expect('"')) return false;
+        out.clear();
+        while (pos_ < text_.size()) {
+            char ch = text_[pos_++];
+            if (ch == '"') return true;
+            if (ch != '\\') {
+                out += ch;
+                continue;
+            }
+            if (pos_ >= text_.size()) return false;
+            ch = text_[pos_++];
+            switch (ch) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    // Only control characters are written escaped; others are kept as '?'
+                    if (pos_ + 4 > text_.size()) return false;
+                    const unsigned long code = std::strtoul(text_.substr(pos_, 4).c_str(), nullptr, 16);
+                    out += code < 0x80 ? static_cast<char>(code) : '?';
+                    pos_ += 4;
+                    break;
+                }
+                default: out += ch; break;
+            }
+        }
+        return false;
+    }
+
+    bool numberValue(double& out) {
+        skipSpace();
+        const char* begin = text_.c_str() + pos_;
+        char* end = nullptr;
+        out = std::strtod(begin, &end);
+        if (end == begin) return false;
+        pos_ += end - begin;
+        return true;
+    }
+
+    // Seeds use all 64 bits, more than a double holds exactly
+    bool unsignedValue(uint64_t& out) {
+        skipSpace();
+        const char* begin = text_.data() + pos_;
+        const char* last = text_.data() + text_.size();
+        const auto [end, ec] = std::from_chars(begin, last, out);
+        if (ec != std::errc() || end == begin) return false;
+        if (end < last && (*end == '.' || *end == 'e' || *end == 'E')) return false;
+        pos_ += end - begin;
+        return true;
+    }
+
+    bool skipValue() {
+        skipSpace();
+        if (pos_ >= text_.size()) return false;
+        const char ch = text_[pos_];
+        if (ch == '"') {
+            std::string ignored;
+            return stringValue(ignored);
+        }
+        if (ch == '{') {
+            return object([&](const std::string&) { return skipValue(); });
+        }
+        if (ch == '[') {
+            ++pos_;
+            if (expect(']')) return true;
+            do {
+                if (!skipValue()) return false;
+            } while (expect(','));
+            return expect(']');
+        }
+        for (const char* literal : {"true", "false", "null"}) {
+            if (text_.compare(pos_, std::strlen(literal), literal) == 0) {
+                pos_ += std::strlen(literal);
+                return true;
+            }
+        }
+        double ignored;
+        return numberValue(ignored);
+    }
+};
+
+// First line of a shell command's output, empty on failure
+std::string commandOutput(const char* command) {
+    std::unique_ptr<FILE, int (*)(FILE*)> pipe(popen(command, "r"), pclose);
+    if (!pipe) return "";
+    char buf[256];
+    std::string out;
+    if (std::fgets(buf, sizeof(buf), pipe.get())) out = buf;
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) out.pop_back();
+    return out;
+}
+
+} // anonymous namespace
+
+const BenchMetric* BenchRun::find(const std::string& name) const {
+    for (const auto& metric : metrics) {
+        if (metric.name == name) return &metric;
+    }
+    return nullptr;
+}
+
+bool BenchHistory::load(const std::string& path) {
+    runs_.clear();
+    std::ifstream in(path);
+    if (!in) return true;
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        BenchRun run;
+        if (JsonReader(line).readRun(run)) {
+            runs_.push_back(std::move(run));
+        } else {
+            std::cerr << "Warning: " << path << ":" << lineNumber << ": skipping malformed run\n";
+        }
+    }
+    return !in.bad();
+}
+
+bool BenchHistory::append(const std::string& path, const BenchRun& run) {
+    std::ofstream out(path, std::ios::app);
+    if (!out) return false;
+
+    out << "{\"commit\":" << quote(run.commit) << ",\"cpu\":" << quote(run.cpu) << ",\"time\":" << quote(run.time)
+        << ",\"seed\":" << run.seed << ",\"scale\":" << number(run.scale) << ",\"repeat\":" << run.repeat
+        << ",\"metrics\":{";
+    for (size_t i = 0; i < run.metrics.size(); ++i) {
+        const BenchMetric& metric = run.metrics[i];
+        out << (i ? "," : "") << quote(metric.name) << ":{\"value\":" << number(metric.value)
+            << ",\"unit\":" << quote(metric.unit) << "}";
+    }
+    out << "}}\n";
+    return static_cast<bool>(out);
+}
+
+std::vector<const BenchRun*> BenchHistory::baseline(const BenchRun& run, size_t count) const {
+    std::vector<const BenchRun*> result;
+    for (auto it = runs_.rbegin(); it != runs_.rend() && result.size() < count; ++it) {
+        if (it->cpu == run.cpu && it->seed == run.seed && it->scale == run.scale) {
+            result.push_back(&*it);
+        }
+    }
+    return result;
+}
+
+std::vector<BenchComparison> BenchHistory::compare(const BenchRun& run, size_t count, double threshold) const {
+    const auto previous = baseline(run, count);
+    std::vector<BenchComparison> comparisons;
+    for (const BenchMetric& metric : run.metrics) {
+        BenchComparison c;
+        c.metric = metric;
+
+        // Earlier runs may not have the metric, or may have measured it in another unit
+        RunningStats stats;
+        for (const BenchRun* prev : previous) {
+            const BenchMetric* old = prev->find(metric.name);
+            if (old && old->unit == metric.unit) stats.add(old->value);
+        }
+        c.baselineRuns = stats.count();
+        if (c.baselineRuns > 0) {
+            c.baselineMean = stats.mean();
+            c.baselineStddev = std::sqrt(stats.variance());
+            if (c.baselineMean > 0) {
+                const double delta = (metric.value - c.baselineMean) / c.baselineMean;
+                c.change = metric.higherIsBetter() ? delta : -delta;
+            }
+        }
+        if (c.baselineRuns >= MIN_BASELINE_RUNS && c.change < -threshold) {
+            const double n = static_cast<double>(c.baselineRuns);
+            const double halfWidth = tQuantile95(c.baselineRuns - 1) * c.baselineStddev * std::sqrt(1 + 1 / n);
+            c.regression = std::abs(metric.value - c.baselineMean) > halfWidth;
+        }
+        comparisons.push_back(c);
+    }
+    return comparisons;
+}
+
+std::string currentCommit() {
+    const std::string commit = commandOutput("git describe --always --dirty --abbrev=12 2>/dev/null");
+    return commit.empty() ? "unknown" : commit;
+}
+
+std::string cpuModel() {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 10, "model name") != 0) continue;
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) break;
+        const size_t start = line.find_first_not_of(" \t", colon + 1);
+        if (start != std::string::npos) return line.substr(start);
+        break;
+    }
+    return "unknown";
+}
+
+std::string utcTimestamp() {
+    const std::time_t now = std::time(nullptr);
+    std::tm utc{};
+    gmtime_r(&now, &utc);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buf;
+}
+
+} // namespace BlockGame
@@ -1,5 +1,6 @@
 #include "board.hpp"
 #include "pieces.hpp"
+#include "trace.hpp"
 #include <bitset>
 #include <sstream>
 #include <stdint.h>
@@ -7,6 +8,7 @@
 namespace BlockGame {
 
 int Board::clearFullLines() {
+    BG_TRACE_COUNT("Board::clearFullLines", 1);
     uint64_t c = data_;
     c &= (c >> 8);
     c &= (c >> 16);
@@ -40,7 +42,9 @@ int Board::clearFullLines() {
     uint64_t total_mask = col_mask | row_mask;
 
     data_ &= ~total_mask;
-    return __builtin_popcountll(col_ind) + __builtin_popcountll(row_ind);
+    const int lines = __builtin_popcountll(col_ind) + __builtin_popcountll(row_ind);
+    BG_TRACE_COUNT("lines cleared", lines);
+    return lines;
 }
 
 int Board::placeAndClear(uint64_t pieceMask) {
@@ -60,6 +64,7 @@ std::vector<Move> Board::getLegalMoves(PieceType type) const {
 }
 
 std::vector<Move> Board::getLegalMoves(const Piece& piece) const {
+    BG_TRACE_SCOPE("Board::getLegalMoves");
     std::vector<Move> moves;
     
     for (int row = 0; row <= piece.shiftTable.maxRow; ++row) {
@@ -74,6 +79,7 @@ std::vector<Move> Board::getLegalMoves(const Piece& piece) const {
 }
 
 int Board::countValidPlacements(PieceType type) const {
+    BG_TRACE_SCOPE("Board::countValidPlacements");
     int count = 0;
     const Piece& piece = getPiece(type);
     
@@ -91,6 +97,27 @@ int Board::countValidPlacements(PieceType type) const {
     return count;
 }
 
+uint64_t Board::fitMask(const Piece& piece) const {
+    const uint64_t empty = ~data_;
+    uint64_t fits = piece.shiftTable.originMask;
+    // Origins are restricted to in-bounds positions, so col + dc never wraps into the next row
+    for (uint64_t cells = piece.baseMask; cells; cells &= cells - 1) {
+        fits &= empty >> __builtin_ctzll(cells);
+    }
+    return fits;
+}
+
+uint64_t Board::clearingFits(const Piece& piece, uint64_t fits) const {
+    uint64_t clearing = 0;
+    for (; fits; fits &= fits - 1) {
+        const int pos = __builtin_ctzll(fits);
+        if (wouldClear(piece.shiftTable.masks[pos], piece.shiftTable.lines[pos])) {
+            clearing |= fits & -fits;
+        }
+    }
+    return clearing;
+}
+
 std::string Board::toString() const {
     std::ostringstream oss;
     oss << "  0 1 2 3 4 5 6 7\n";
@@ -0,0 +1,203 @@
+#include "dataset.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BlockGame {
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+DatasetWriter::~DatasetWriter() {
+    close();
+}
+
+bool DatasetWriter::open(const std::string& path, uint64_t reservoirCapacity, uint64_t seed) {
+    close();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+
+    failed_ = false;
+    capacity_ = reservoirCapacity;
+    seen_ = 0;
+    written_ = 0;
+    games_ = 0;
+    rng_.seed(seed);
+    reservoir_.clear();
+    chunk_.clear();
+    chunk_.reserve(Dataset::CHUNK_SAMPLES);
+
+    // Placeholder header, the sample count is filled in by close()
+    uint8_t header[Dataset::HEADER_BYTES] = {};
+    if (std::fwrite(header, 1, sizeof(header), file_) != sizeof(header)) failed_ = true;
+    return true;
+}
+
+void DatasetWriter::beginGame(uint64_t, const Game& game) {
+    pending_.clear();
+    boardBefore_ = game.board().data();
+}
+
+void DatasetWriter::onHandDrawn(const Game& game) {
+    boardBefore_ = game.board().data();
+}
+
+void DatasetWriter::onPlacement(const Game& game, int handIndex, int row, int col, int linesCleared) {
+    // Called before the move is committed: handUsed() and score() still describe the position
+    DatasetSample sample{};
+    sample.board = boardBefore_;
+    for (int i = 0; i < Game::HAND_SIZE; ++i) {
+        sample.hand[i] = game.handUsed()[i] ? DatasetSample::UNUSED_SLOT : static_cast<uint8_t>(game.hand()[i]);
+    }
+    sample.moveSlot = static_cast<uint8_t>(handIndex);
+    sample.movePos = static_cast<uint8_t>(row * 8 + col);
+    sample.linesCleared = static_cast<uint8_t>(linesCleared);
+    sample.turn = static_cast<uint16_t>(game.turnNumber());
+    sample.scoreBefore = game.score();
+    sample.gameIndex = games_;
+    pending_.push_back(sample);
+
+    boardBefore_ = game.board().data();
+}
+
+void DatasetWriter::endGame(const Game& game) {
+    for (auto& sample : pending_) {
+        sample.finalScore = game.score();
+        sample.returnToGo = game.score() - sample.scoreBefore;
+    }
+    games_++;
+
+    if (capacity_ == 0) {
+        writeSamples(pending_.data(), pending_.size());
+        seen_ += pending_.size();
+        return;
+    }
+
+    // Algorithm R: after n samples each one is kept with probability capacity / n
+    for (const auto& sample : pending_) {
+        seen_++;
+        if (reservoir_.size() < capacity_) {
+            reservoir_.push_back(sample);
+        } else {
+            std::uniform_int_distribution<uint64_t> dist(0, seen_ - 1);
+            const uint64_t slot = dist(rng_);
+            if (slot < capacity_) reservoir_[slot] = sample;
+        }
+    }
+}
+
+void DatasetWriter::writeSamples(const DatasetSample* samples, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        chunk_.push_back(samples[i]);
+        if (chunk_.size() == Dataset::CHUNK_SAMPLES) {
+            if (std::fwrite(chunk_.data(), sizeof(DatasetSample), chunk_.size(), file_) != chunk_.size()) {
+                failed_ = true;
+            }
+            written_ += chunk_.size();
+            chunk_.clear();
+        }
+    }
+}
+
+bool DatasetWriter::close() {
+    if (!file_) return !failed_;
+
+    if (capacity_ != 0) {
+        writeSamples(reservoir_.data(), reservoir_.size());
+        reservoir_.clear();
+    }
+    if (!chunk_.empty()) {
+        if (std::fwrite(chunk_.data(), sizeof(DatasetSample), chunk_.size(), file_) != chunk_.size()) {
+            failed_ = true;
+        }
+        written_ += chunk_.size();
+        chunk_.clear();
+    }
+
+    uint8_t header[Dataset::HEADER_BYTES] = {};
+    const uint16_t version = Dataset::VERSION;
+    const uint16_t stride = sizeof(DatasetSample);
+    const uint64_t count = written_;
+    std::memcpy(header, Dataset::MAGIC, 4);
+    std::memcpy(header + 4, &version, 2);
+    std::memcpy(header + 6, &stride, 2);
+    std::memcpy(header + 12, &count, 8);
+    if (std::fseek(file_, 0, SEEK_SET) != 0 || std::fwrite(header, 1, sizeof(header), file_) != sizeof(header)) {
+        failed_ = true;
+    }
+    if (std::fclose(file_) != 0) failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+DatasetShard::~DatasetShard() {
+    close();
+}
+
+bool DatasetShard::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < Dataset::HEADER_BYTES) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+    mapping_ = mapping;
+    mappedBytes_ = static_cast<size_t>(st.st_size);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapping);
+    uint16_t version, stride;
+    uint64_t count;
+    std::memcpy(&version, bytes + 4, 2);
+    std::memcpy(&stride, bytes + 6, 2);
+    std::memcpy(&count, bytes + 12, 8);
+    if (std::memcmp(bytes, Dataset::MAGIC, 4) != 0 || version != Dataset::VERSION ||
+        stride != sizeof(DatasetSample) ||
+        count > (mappedBytes_ - Dataset::HEADER_BYTES) / sizeof(DatasetSample)) {
+        close();
+        return false;
+    }
+
+    // The header is 32 bytes and the mapping page aligned, so samples are naturally aligned
+    samples_ = reinterpret_cast<const DatasetSample*>(bytes + Dataset::HEADER_BYTES);
+    count_ = count;
+    return true;
+}
+
+void DatasetShard::close() {
+    if (mapping_) munmap(mapping_, mappedBytes_);
+    mapping_ = nullptr;
+    mappedBytes_ = 0;
+    samples_ = nullptr;
+    count_ = 0;
+}
+
+bool writeDatasetIndex(const std::string& dir, const std::vector<std::string>& shardNames,
+                       const std::vector<uint64_t>& counts) {
+    std::ofstream out(dir + "/index.txt");
+    if (!out) return false;
+    uint64_t total = 0;
+    for (uint64_t c : counts) total += c;
+
+    out << "# BlockGame dataset: shard file, sample count (stride " << sizeof(DatasetSample) << " bytes)\n";
+    out << "total " << total << "\n";
+    for (size_t i = 0; i < shardNames.size(); ++i) {
+        out << shardNames[i] << " " << counts[i] << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+} // namespace BlockGame
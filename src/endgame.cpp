@@ -0,0 +1,201 @@
+#include "endgame.hpp"
+#include "pieces.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BlockGame {
+
+namespace {
+
+constexpr char MAGIC[4] = {'B', 'G', 'T', 'B'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t HEADER_BYTES = 32;
+
+inline int emptySquares(uint64_t board) {
+    return __builtin_popcountll(~board);
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// Solver
+// ---------------------------------------------------------------------------
+
+EndgameSolver::EndgameSolver(const Config& config)
+    : config_(config), memo_(config.hands + 1), planners_(config.hands + 1) {
+    for (auto& planner : planners_) {
+        planner.setClearingFirst(config.clearingFirst);
+    }
+}
+
+CutoffHistogram EndgameSolver::cutoffs() const {
+    CutoffHistogram total;
+    for (const auto& planner : planners_) {
+        total.merge(planner.cutoffs());
+    }
+    return total;
+}
+
+bool EndgameSolver::inRange(const Board& board) const {
+    return emptySquares(board.data()) <= config_.maxEmpty;
+}
+
+double EndgameSolver::solve(const Board& board) {
+    return solve(board.data(), config_.hands);
+}
+
+double EndgameSolver::solve(uint64_t board, int hands) {
+    const bool survival = config_.objective == Objective::SURVIVAL;
+    if (hands == 0) return survival ? 1.0 : 0.0;
+
+    auto& memo = memo_[hands];
+    if (auto it = memo.find(board); it != memo.end()) return it->second;
+
+    HandPlanner& planner = planners_[hands];
+    double total = 0;
+
+    // Each multiset a <= b <= c stands for all of its orderings
+    for (int a = 0; a < NUM_PIECES; ++a) {
+        for (int b = a; b < NUM_PIECES; ++b) {
+            for (int c = b; c < NUM_PIECES; ++c) {
+                const int orderings = (a == c) ? 1 : (a == b || b == c) ? 3 : 6;
+                PieceType pieces[3] = {static_cast<PieceType>(a), static_cast<PieceType>(b),
+                                       static_cast<PieceType>(c)};
+
+                // Surviving the last hand only needs one complete line of play, not all of them
+                if (survival && hands == 1) {
+                    if (planner.feasible(Board(board), pieces, 3)) total += orderings;
+                    continue;
+                }
+
+                planner.expand(Board(board), pieces, 3);
+
+                double best = 0;
+                if (!planner.complete()) {
+                    // The game ends inside this hand
+                    if (!survival) {
+                        for (const auto& leaf : planner.leaves()) best = std::max<double>(best, leaf.points);
+                    }
+                } else {
+                    for (const auto& leaf : planner.leaves()) {
+                        double value;
+                        if (emptySquares(leaf.board) > config_.maxEmpty) {
+                            value = survival ? 1.0 : leaf.points;
+                        } else {
+                            value = solve(leaf.board, hands - 1) + (survival ? 0.0 : leaf.points);
+                        }
+                        best = std::max(best, value);
+                        if (survival && best >= 1.0) break;
+                    }
+                }
+                total += orderings * best;
+            }
+        }
+    }
+
+    const double value = total / (static_cast<double>(NUM_PIECES) * NUM_PIECES * NUM_PIECES);
+    memo.emplace(board, value);
+    return value;
+}
+
+bool EndgameSolver::save(const std::string& path) const {
+    std::vector<EndgameTablebase::Entry> entries;
+    entries.reserve(size());
+    for (const auto& [board, value] : memo_[config_.hands]) entries.push_back({board, value});
+    std::sort(entries.begin(), entries.end(),
+              [](const EndgameTablebase::Entry& x, const EndgameTablebase::Entry& y) { return x.board < y.board; });
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    uint8_t header[HEADER_BYTES] = {};
+    const uint32_t fields[5] = {VERSION, static_cast<uint32_t>(config_.hands),
+                                static_cast<uint32_t>(config_.maxEmpty),
+                                static_cast<uint32_t>(config_.objective), 0};
+    const uint64_t count = entries.size();
+    std::memcpy(header, MAGIC, 4);
+    std::memcpy(header + 4, fields, sizeof(fields));
+    std::memcpy(header + 24, &count, 8);
+
+    bool ok = std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    ok = ok && std::fwrite(entries.data(), sizeof(EndgameTablebase::Entry), entries.size(), file) == entries.size();
+    if (std::fclose(file) != 0) ok = false;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Tablebase
+// ---------------------------------------------------------------------------
+
+EndgameTablebase::~EndgameTablebase() {
+    close();
+}
+
+bool EndgameTablebase::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_BYTES) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+    mapping_ = mapping;
+    mappedBytes_ = static_cast<size_t>(st.st_size);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapping);
+    uint32_t fields[5];
+    uint64_t count;
+    std::memcpy(fields, bytes + 4, sizeof(fields));
+    std::memcpy(&count, bytes + 24, 8);
+    if (std::memcmp(bytes, MAGIC, 4) != 0 || fields[0] != VERSION || fields[3] > 1 ||
+        count > (mappedBytes_ - HEADER_BYTES) / sizeof(Entry)) {
+        close();
+        return false;
+    }
+
+    entries_ = reinterpret_cast<const Entry*>(bytes + HEADER_BYTES);
+    count_ = count;
+    hands_ = static_cast<int>(fields[1]);
+    maxEmpty_ = static_cast<int>(fields[2]);
+    objective_ = static_cast<EndgameSolver::Objective>(fields[3]);
+    return true;
+}
+
+void EndgameTablebase::close() {
+    if (mapping_) munmap(mapping_, mappedBytes_);
+    mapping_ = nullptr;
+    mappedBytes_ = 0;
+    entries_ = nullptr;
+    count_ = 0;
+}
+
+bool EndgameTablebase::probe(const Board& board, double& value) const {
+    const uint64_t key = board.data();
+    const Entry* end = entries_ + count_;
+    const Entry* it = std::lower_bound(entries_, end, key,
+                                       [](const Entry& entry, uint64_t k) { return entry.board < k; });
+    if (it == end || it->board != key) return false;
+    value = it->value;
+    return true;
+}
+
+double EndgameEvaluator::evaluate(const Board& board) const {
+    const double value = base_->evaluate(board);
+    double survival;
+    if (__builtin_popcountll(~board.data()) <= table_->maxEmpty() && table_->probe(board, survival)) {
+        return value - penalty_ * (1.0 - survival);
+    }
+    return value;
+}
+
+} // namespace BlockGame
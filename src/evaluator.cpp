@@ -0,0 +1,119 @@
+#include "evaluator.hpp"
+#include "pieces.hpp"
+#include "trace.hpp"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace BlockGame {
+
+namespace {
+
+constexpr uint64_t NOT_COL_0 = ~Board::colMask(0);
+constexpr uint64_t NOT_COL_7 = ~Board::colMask(7);
+
+// Empty squares whose orthogonal neighbours are all filled or off-board
+inline int countIsolatedHoles(uint64_t empty) {
+    uint64_t neighbours = (empty << 8) | (empty >> 8)
+                        | ((empty << 1) & NOT_COL_0)
+                        | ((empty >> 1) & NOT_COL_7);
+    return __builtin_popcountll(empty & ~neighbours);
+}
+
+// Adjacent pairs (horizontal and vertical) that differ in occupancy
+inline int countTransitions(uint64_t filled) {
+    uint64_t horizontal = (filled ^ (filled >> 1)) & NOT_COL_7;
+    uint64_t vertical = (filled ^ (filled >> 8)) & (Board::FULL_BOARD >> 8);
+    return __builtin_popcountll(horizontal) + __builtin_popcountll(vertical);
+}
+
+} // anonymous namespace
+
+FeatureVector computeFeatures(const Board& board) {
+    FeatureVector f{};
+    const uint64_t filled = board.data();
+    const uint64_t empty = ~filled;
+
+    f[FEATURE_EMPTY_SQUARES] = __builtin_popcountll(empty);
+    f[FEATURE_ISOLATED_HOLES] = countIsolatedHoles(empty);
+    f[FEATURE_TRANSITIONS] = countTransitions(filled);
+
+    int placeable = 0;
+    int mobility = 0;
+    for (const auto& piece : getAllPieces()) {
+        int n = __builtin_popcountll(board.fitMask(piece));
+        placeable += (n != 0);
+        mobility += n;
+    }
+    f[FEATURE_PLACEABLE_PIECES] = placeable;
+    f[FEATURE_MOBILITY] = mobility;
+
+    return f;
+}
+
+const char* featureName(Feature feature) {
+    switch (feature) {
+        case FEATURE_EMPTY_SQUARES: return "empty_squares";
+        case FEATURE_ISOLATED_HOLES: return "isolated_holes";
+        case FEATURE_TRANSITIONS: return "transitions";
+        case FEATURE_PLACEABLE_PIECES: return "placeable_pieces";
+        case FEATURE_MOBILITY: return "mobility";
+        default: return "unknown";
+    }
+}
+
+HeuristicWeights HeuristicWeights::defaults() {
+    HeuristicWeights weights{};
+    weights.w[FEATURE_EMPTY_SQUARES] = 1.0;
+    weights.w[FEATURE_ISOLATED_HOLES] = -4.0;
+    weights.w[FEATURE_TRANSITIONS] = -0.5;
+    weights.w[FEATURE_PLACEABLE_PIECES] = 2.0;
+    weights.w[FEATURE_MOBILITY] = 0.05;
+    return weights;
+}
+
+bool HeuristicWeights::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    HeuristicWeights loaded = defaults();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        std::string name;
+        double value;
+        if (!(iss >> name >> value)) return false;
+
+        int index = -1;
+        for (int i = 0; i < NUM_FEATURES; ++i) {
+            if (name == featureName(static_cast<Feature>(i))) index = i;
+        }
+        if (index < 0) return false;
+        loaded.w[index] = value;
+    }
+    *this = loaded;
+    return true;
+}
+
+bool HeuristicWeights::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << std::setprecision(17);
+    for (int i = 0; i < NUM_FEATURES; ++i) {
+        out << featureName(static_cast<Feature>(i)) << " " << w[i] << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+double HeuristicEvaluator::evaluate(const Board& board) const {
+    BG_TRACE_SCOPE("HeuristicEvaluator::evaluate");
+    const FeatureVector f = computeFeatures(board);
+    double value = 0;
+    for (int i = 0; i < NUM_FEATURES; ++i) {
+        value += weights_.w[i] * f[i];
+    }
+    return value;
+}
+
+} // namespace BlockGame
@@ -1,4 +1,5 @@
 #include "game.hpp"
+#include "trace.hpp"
 #include <chrono>
 #include <algorithm>
 #include <iostream>
@@ -15,6 +16,7 @@ Game::Game(uint64_t seed)
     , handUsed_{}
     , score_(0)
     , turnNumber_(0)
+    , movesMade_(0)
     , gameOver_(false)
     , rng_(seed) {
     drawHand();
@@ -24,18 +26,24 @@ void Game::reset() {
     board_ = Board();
     score_ = 0;
     turnNumber_ = 0;
+    movesMade_ = 0;
     gameOver_ = false;
     std::fill(handUsed_.begin(), handUsed_.end(), false);
     drawHand();
 }
 
 void Game::drawHand() {
-    std::uniform_int_distribution<int> dist(0, NUM_PIECES - 1);
-    for (int i = 0; i < HAND_SIZE; ++i) {
-        hand_[i] = static_cast<PieceType>(dist(rng_));
-        handUsed_[i] = false;
+    BG_TRACE_SCOPE("Game::drawHand");
+    {
+        BG_TRACE_SCOPE("Game::drawHand/rng");
+        std::uniform_int_distribution<int> dist(0, NUM_PIECES - 1);
+        for (int i = 0; i < HAND_SIZE; ++i) {
+            hand_[i] = static_cast<PieceType>(dist(rng_));
+            handUsed_[i] = false;
+        }
     }
     turnNumber_++;
+    if (observer_) observer_->onHandDrawn(*this);
     checkGameOver();
 }
 
@@ -102,6 +110,7 @@ int Game::makeMove(const Move& move, bool drawNewHand) {
 }
 
 int Game::placePiece(int handIndex, int row, int col, bool drawNewHand) {
+    BG_TRACE_SCOPE("Game::placePiece");
     if (!canPlace(handIndex, row, col)) {
         return 0;
     }
@@ -111,6 +120,7 @@ int Game::placePiece(int handIndex, int row, int col, bool drawNewHand) {
     
     // Delegate to board for modification and line clearing
     int linesCleared = board_.placeAndClear(mask);
+    if (observer_) observer_->onPlacement(*this, handIndex, row, col, linesCleared);
     
     // Update game state
     commitMove(handIndex, linesCleared, drawNewHand);
@@ -121,6 +131,7 @@ int Game::placePiece(int handIndex, int row, int col, bool drawNewHand) {
 void Game::commitMove(int handIndex, int linesCleared, bool drawNewHand) {
     score_ += calculateClearScore(linesCleared);
     handUsed_[handIndex] = true;
+    movesMade_++;
     
     bool allPlaced = std::all_of(handUsed_.begin(), handUsed_.end(), [](bool b) { return b; });
     
@@ -136,6 +147,20 @@ void Game::newTurn() {
 }
 
 void Game::checkGameOver() {
+    BG_TRACE_SCOPE("Game::checkGameOver");
+    if (handCache_) {
+        PieceType remaining[HAND_SIZE];
+        int count = 0;
+        for (int i = 0; i < HAND_SIZE; ++i) {
+            if (!handUsed_[i]) remaining[count++] = hand_[i];
+        }
+        bool feasible = false;
+        if (count > 0 && handCache_->probe(HandCache::makeKey(board_.data(), remaining, count), feasible) &&
+            feasible) {
+            BG_TRACE_COUNT("Game::checkGameOver/cache hits", 1);
+            return;
+        }
+    }
     if (!hasLegalMoves()) {
         gameOver_ = true;
     }
@@ -0,0 +1,70 @@
+#include "hand_cache.hpp"
+#include <algorithm>
+
+namespace BlockGame {
+
+namespace {
+
+// Flags above the 20 bits a key's hand uses
+constexpr uint64_t HAND_MASK = (1ULL << 20) - 1;
+constexpr uint64_t VALID = 1ULL << 63;
+constexpr uint64_t FEASIBLE = 1ULL << 62;
+constexpr int WORDS_PER_ENTRY = 2;
+
+} // anonymous namespace
+
+HandCache::HandCache(int bits)
+    : words_(new std::atomic<uint64_t>[(size_t{1} << bits) * WORDS_PER_ENTRY])
+    , mask_((size_t{1} << bits) - 1) {
+    clear();
+}
+
+HandCache::Key HandCache::makeKey(uint64_t board, const PieceType* pieces, int count) {
+    int sorted[3] = {0, 0, 0};
+    std::copy(pieces, pieces + count, sorted);
+    // Sorting network over the first count pieces
+    auto order = [&](int i, int j) {
+        if (sorted[j] < sorted[i]) std::swap(sorted[i], sorted[j]);
+    };
+    if (count >= 2) order(0, 1);
+    if (count == 3) {
+        order(1, 2);
+        order(0, 1);
+    }
+    uint64_t hand = static_cast<uint64_t>(count);
+    for (int i = 0; i < count; ++i) {
+        hand |= static_cast<uint64_t>(sorted[i]) << (2 + 6 * i);
+    }
+    return {board, hand};
+}
+
+size_t HandCache::slot(const Key& key) const {
+    uint64_t h = key.board * 0x9e3779b97f4a7c15ULL ^ key.hand * 0xc2b2ae3d27d4eb4fULL;
+    h ^= h >> 29;
+    return static_cast<size_t>(h) & mask_;
+}
+
+bool HandCache::probe(const Key& key, bool& feasible) const {
+    const std::atomic<uint64_t>* entry = &words_[slot(key) * WORDS_PER_ENTRY];
+    const uint64_t w0 = entry[0].load(std::memory_order_relaxed);
+    const uint64_t data = entry[1].load(std::memory_order_relaxed);
+
+    if (!(data & VALID) || (w0 ^ data) != key.board || (data & HAND_MASK) != key.hand) return false;
+    feasible = (data & FEASIBLE) != 0;
+    return true;
+}
+
+void HandCache::store(const Key& key, bool feasible) {
+    std::atomic<uint64_t>* entry = &words_[slot(key) * WORDS_PER_ENTRY];
+    const uint64_t data = key.hand | VALID | (feasible ? FEASIBLE : 0);
+    entry[0].store(key.board ^ data, std::memory_order_relaxed);
+    entry[1].store(data, std::memory_order_relaxed);
+}
+
+void HandCache::clear() {
+    for (size_t i = 0; i < capacity() * WORDS_PER_ENTRY; ++i) {
+        words_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace BlockGame
@@ -0,0 +1,298 @@
+#include "nn_evaluator.hpp"
+#include "pieces.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace BlockGame {
+
+namespace {
+
+constexpr char MAGIC[4] = {'B', 'G', 'N', 'N'};
+constexpr uint32_t VERSION = 1;
+constexpr int ACTIVATION_ONE = 127;  // Quantized 1.0 for activations and layer 1 weights
+constexpr int WEIGHT2_SHIFT = 6;     // Layer 2 weights: 64 == 1.0
+
+inline uint8_t clippedRelu(int32_t x) {
+    return static_cast<uint8_t>(std::clamp(x, 0, ACTIVATION_ONE));
+}
+
+// Dot product of hidden1 u8 activations with i8 weights
+inline int32_t dotU8I8(const uint8_t* a, const int8_t* w, int n) {
+#ifdef __AVX2__
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += NNEvaluator::SIMD_WIDTH) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+        // 127 * 127 * 2 fits in int16, so maddubs cannot saturate
+        __m256i prod16 = _mm256_maddubs_epi16(va, vw);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(prod16, ones));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += static_cast<int32_t>(a[i]) * w[i];
+    }
+    return sum;
+#endif
+}
+
+template <typename T>
+bool readArray(std::istream& in, std::vector<T>& v, size_t count) {
+    v.resize(count);
+    in.read(reinterpret_cast<char*>(v.data()), count * sizeof(T));
+    return static_cast<bool>(in);
+}
+
+template <typename T>
+void writeArray(std::ostream& out, const std::vector<T>& v) {
+    out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::istream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return static_cast<bool>(in);
+}
+
+template <typename T>
+void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // anonymous namespace
+
+int NNEvaluator::inputIndexHand(int piece) const {
+    return BOARD_INPUTS + piece;
+}
+
+int NNEvaluator::inputIndexFit(int piece) const {
+    return BOARD_INPUTS + ((inputFlags_ & INPUT_HAND) ? HAND_INPUTS : 0) + piece;
+}
+
+/*
+ * Weight file layout (little-endian):
+ *   char[4] "BGNN", u32 version, u32 inputFlags, u32 hidden1, u32 hidden2
+ *   i16 w1[numInputs][hidden1], i16 b1[hidden1]
+ *   i8  w2[hidden2][hidden1],   i32 b2[hidden2]
+ *   f32 w3[hidden2], f32 b3, f32 outputScale
+ */
+bool NNEvaluator::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    char magic[4];
+    uint32_t version, flags, h1, h2;
+    in.read(magic, 4);
+    if (!in || std::memcmp(magic, MAGIC, 4) != 0) return false;
+    if (!readValue(in, version) || version != VERSION) return false;
+    if (!readValue(in, flags) || !readValue(in, h1) || !readValue(in, h2)) return false;
+    if (h1 == 0 || h1 % SIMD_WIDTH != 0 || h1 > MAX_HIDDEN1 || h2 == 0 || h2 > MAX_HIDDEN2) return false;
+
+    NNEvaluator net;
+    net.inputFlags_ = flags & (INPUT_HAND | INPUT_FIT_MASK);
+    net.hidden1_ = static_cast<int>(h1);
+    net.hidden2_ = static_cast<int>(h2);
+    net.numInputs_ = BOARD_INPUTS + ((flags & INPUT_HAND) ? HAND_INPUTS : 0) + ((flags & INPUT_FIT_MASK) ? FIT_INPUTS : 0);
+
+    if (!readArray(in, net.w1_, static_cast<size_t>(net.numInputs_) * h1) ||
+        !readArray(in, net.b1_, h1) ||
+        !readArray(in, net.w2_, static_cast<size_t>(h2) * h1) ||
+        !readArray(in, net.b2_, h2) ||
+        !readArray(in, net.w3_, h2) ||
+        !readValue(in, net.b3_) ||
+        !readValue(in, net.outputScale_)) {
+        return false;
+    }
+
+    net.precision_ = precision_;
+    *this = std::move(net);
+    finishLoad();
+    return true;
+}
+
+bool NNEvaluator::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    out.write(MAGIC, 4);
+    writeValue(out, VERSION);
+    writeValue(out, inputFlags_);
+    writeValue(out, static_cast<uint32_t>(hidden1_));
+    writeValue(out, static_cast<uint32_t>(hidden2_));
+    writeArray(out, w1_);
+    writeArray(out, b1_);
+    writeArray(out, w2_);
+    writeArray(out, b2_);
+    writeArray(out, w3_);
+    writeValue(out, b3_);
+    writeValue(out, outputScale_);
+    return static_cast<bool>(out);
+}
+
+bool NNEvaluator::initRandom(uint32_t inputFlags, int hidden1, int hidden2, uint64_t seed) {
+    if (hidden1 > MAX_HIDDEN1 || hidden2 > MAX_HIDDEN2) return false;
+    inputFlags_ = inputFlags & (INPUT_HAND | INPUT_FIT_MASK);
+    hidden1_ = std::max(SIMD_WIDTH, (hidden1 + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH);
+    hidden2_ = std::max(1, hidden2);
+    numInputs_ = BOARD_INPUTS + ((inputFlags_ & INPUT_HAND) ? HAND_INPUTS : 0)
+               + ((inputFlags_ & INPUT_FIT_MASK) ? FIT_INPUTS : 0);
+
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> w1Dist(-12, 12);
+    std::uniform_int_distribution<int> w2Dist(-20, 20);
+    std::normal_distribution<float> w3Dist(0.0f, 0.3f);
+
+    w1_.resize(static_cast<size_t>(numInputs_) * hidden1_);
+    for (auto& w : w1_) w = static_cast<int16_t>(w1Dist(rng));
+    b1_.assign(hidden1_, ACTIVATION_ONE / 4);
+    w2_.resize(static_cast<size_t>(hidden2_) * hidden1_);
+    for (auto& w : w2_) w = static_cast<int8_t>(w2Dist(rng));
+    b2_.assign(hidden2_, 0);
+    w3_.resize(hidden2_);
+    for (auto& w : w3_) w = w3Dist(rng);
+    b3_ = 0;
+    outputScale_ = 100.0f;
+    finishLoad();
+    return true;
+}
+
+void NNEvaluator::finishLoad() {
+    static std::atomic<uint64_t> nextWeightsId{1};
+    weightsId_ = nextWeightsId++;
+    w2f_.resize(w2_.size());
+    for (size_t i = 0; i < w2_.size(); ++i) {
+        w2f_[i] = static_cast<float>(w2_[i]) / (1 << WEIGHT2_SHIFT);
+    }
+}
+
+NNEvaluator::Features NNEvaluator::features(const Board& board, const PieceType* pieces, int count) const {
+    Features f{};
+    f[0] = board.data();
+
+    if (inputFlags_ & INPUT_HAND) {
+        for (int i = 0; i < count; ++i) {
+            const int bit = inputIndexHand(pieces[i]);
+            f[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+    if (inputFlags_ & INPUT_FIT_MASK) {
+        const auto& all = getAllPieces();
+        for (int p = 0; p < NUM_PIECES; ++p) {
+            if (board.fitMask(all[p]) != 0) {
+                const int bit = inputIndexFit(p);
+                f[bit / 64] |= 1ULL << (bit % 64);
+            }
+        }
+    }
+    return f;
+}
+
+void NNEvaluator::refresh(Accumulator& acc, const Features& features) const {
+    acc.values.assign(b1_.begin(), b1_.end());
+    int16_t* values = acc.values.data();
+    for (size_t word = 0; word < features.size(); ++word) {
+        for (uint64_t bits = features[word]; bits; bits &= bits - 1) {
+            const int16_t* column = &w1_[(word * 64 + __builtin_ctzll(bits)) * hidden1_];
+            for (int j = 0; j < hidden1_; ++j) values[j] += column[j];
+        }
+    }
+    acc.features = features;
+}
+
+void NNEvaluator::update(Accumulator& acc, const Features& features) const {
+    if (acc.values.size() != static_cast<size_t>(hidden1_)) {
+        refresh(acc, features);
+        return;
+    }
+
+    // A delta touching more columns than a refresh would is not worth it
+    int changed = 0, active = 0;
+    for (size_t word = 0; word < features.size(); ++word) {
+        changed += __builtin_popcountll(acc.features[word] ^ features[word]);
+        active += __builtin_popcountll(features[word]);
+    }
+    if (changed > active) {
+        refresh(acc, features);
+        return;
+    }
+
+    int16_t* values = acc.values.data();
+    for (size_t word = 0; word < features.size(); ++word) {
+        const uint64_t added = features[word] & ~acc.features[word];
+        const uint64_t removed = acc.features[word] & ~features[word];
+        for (uint64_t bits = added; bits; bits &= bits - 1) {
+            const int16_t* column = &w1_[(word * 64 + __builtin_ctzll(bits)) * hidden1_];
+            for (int j = 0; j < hidden1_; ++j) values[j] += column[j];
+        }
+        for (uint64_t bits = removed; bits; bits &= bits - 1) {
+            const int16_t* column = &w1_[(word * 64 + __builtin_ctzll(bits)) * hidden1_];
+            for (int j = 0; j < hidden1_; ++j) values[j] -= column[j];
+        }
+    }
+    acc.features = features;
+}
+
+double NNEvaluator::forward(const Accumulator& acc) const {
+    alignas(32) uint8_t a1[MAX_HIDDEN1];
+    for (int j = 0; j < hidden1_; ++j) {
+        a1[j] = clippedRelu(acc.values[j]);
+    }
+
+    float out = b3_;
+    if (precision_ == Precision::INT8) {
+        for (int k = 0; k < hidden2_; ++k) {
+            const int32_t sum = dotU8I8(a1, &w2_[static_cast<size_t>(k) * hidden1_], hidden1_) + b2_[k];
+            out += w3_[k] * (clippedRelu(sum >> WEIGHT2_SHIFT) / static_cast<float>(ACTIVATION_ONE));
+        }
+    } else {
+        alignas(32) float a1f[MAX_HIDDEN1];
+        for (int j = 0; j < hidden1_; ++j) a1f[j] = a1[j];
+        for (int k = 0; k < hidden2_; ++k) {
+            const float* w = &w2f_[static_cast<size_t>(k) * hidden1_];
+            float sum = 0;
+            for (int j = 0; j < hidden1_; ++j) sum += a1f[j] * w[j];
+            sum += b2_[k] / static_cast<float>(1 << WEIGHT2_SHIFT);
+            const float a2 = std::clamp(sum, 0.0f, static_cast<float>(ACTIVATION_ONE)) / ACTIVATION_ONE;
+            out += w3_[k] * a2;
+        }
+    }
+    return static_cast<double>(out) * outputScale_;
+}
+
+double NNEvaluator::evaluate(const Board& board) const {
+    return evaluate(board, nullptr, 0);
+}
+
+double NNEvaluator::evaluate(const Board& board, const PieceType* pieces, int count) const {
+    // Per-thread accumulator, reused across calls so sibling positions are cheap
+    thread_local uint64_t owner = 0;
+    thread_local Accumulator acc;
+    if (owner != weightsId_) {
+        owner = weightsId_;
+        acc.values.clear();
+    }
+    update(acc, features(board, pieces, count));
+    return forward(acc);
+}
+
+void NNEvaluator::evaluateBatch(const Board* boards, size_t count, float* out) const {
+    Accumulator acc;
+    for (size_t i = 0; i < count; ++i) {
+        update(acc, features(boards[i]));
+        out[i] = static_cast<float>(forward(acc));
+    }
+}
+
+} // namespace BlockGame
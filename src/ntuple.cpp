@@ -0,0 +1,243 @@
+#include "ntuple.hpp"
+#include "strategy.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace BlockGame {
+
+namespace {
+
+constexpr char MAGIC[4] = {'B', 'G', 'N', 'T'};
+constexpr uint32_t VERSION = 1;
+
+inline uint64_t extractBits(uint64_t board, uint64_t mask) {
+#ifdef __BMI2__
+    return _pext_u64(board, mask);
+#else
+    uint64_t result = 0;
+    int bit = 0;
+    for (uint64_t m = mask; m; m &= m - 1, ++bit) {
+        if (board & (m & -m)) result |= 1ULL << bit;
+    }
+    return result;
+#endif
+}
+
+// The 8 symmetries of the square applied to (row, col)
+inline int transformCell(int cell, int symmetry) {
+    const int r = cell / 8, c = cell % 8;
+    int nr = r, nc = c;
+    switch (symmetry) {
+        case 0: nr = r;     nc = c;     break;  // Identity
+        case 1: nr = c;     nc = 7 - r; break;  // Rotate 90
+        case 2: nr = 7 - r; nc = 7 - c; break;  // Rotate 180
+        case 3: nr = 7 - c; nc = r;     break;  // Rotate 270
+        case 4: nr = r;     nc = 7 - c; break;  // Mirror columns
+        case 5: nr = 7 - r; nc = c;     break;  // Mirror rows
+        case 6: nr = c;     nc = r;     break;  // Transpose
+        case 7: nr = 7 - c; nc = 7 - r; break;  // Anti-transpose
+    }
+    return nr * 8 + nc;
+}
+
+// Squares of one pattern in canonical (row-major) order, empty on a bad spec
+std::vector<int> patternCells(const std::string& shape, int a, int b) {
+    int height = 0, width = 0, row = a, col = b;
+    if (shape == "3x3") {
+        height = 3; width = 3;
+    } else if (shape == "2x4") {
+        height = 2; width = 4;
+    } else if (shape == "4x2") {
+        height = 4; width = 2;
+    } else if (shape == "row") {
+        height = 1; width = 8; col = 0;
+    } else if (shape == "col") {
+        height = 8; width = 1; row = 0; col = a;
+    } else {
+        return {};
+    }
+    if (row < 0 || col < 0 || row + height > 8 || col + width > 8) return {};
+
+    std::vector<int> cells;
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            cells.push_back((row + r) * 8 + col + c);
+        }
+    }
+    return cells;
+}
+
+} // anonymous namespace
+
+const char* const NTupleEvaluator::DEFAULT_SPEC = "3x3:0,0;3x3:1,1;2x4:0,0;row:1";
+
+NTupleEvaluator::NTupleEvaluator() {
+    build(DEFAULT_SPEC);
+}
+
+NTupleEvaluator::NTupleEvaluator(const std::string& spec) {
+    build(spec);
+}
+
+bool NTupleEvaluator::build(const std::string& spec) {
+    spec_.clear();
+    patterns_.clear();
+    images_.clear();
+    perms_.clear();
+    weights_.clear();
+
+    std::vector<std::vector<int>> canonical;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ';')) {
+        if (item.empty()) continue;
+        const size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        const std::string shape = item.substr(0, colon);
+        // Rectangles take "row,col"; a full row or column takes just its index
+        const bool twoCoords = shape != "row" && shape != "col";
+        int a = 0, b = 0;
+        char comma = 0;
+        std::istringstream coords(item.substr(colon + 1));
+        if (!(coords >> a)) return false;
+        if (twoCoords && !(coords >> comma >> b && comma == ',')) return false;
+        if (!(coords >> std::ws).eof()) return false;
+        std::vector<int> cells = patternCells(shape, a, b);
+        if (cells.empty()) return false;
+        canonical.push_back(std::move(cells));
+    }
+    if (canonical.empty()) return false;
+
+    uint32_t tableSize = 0;
+    for (const auto& cells : canonical) {
+        const uint32_t tableOffset = tableSize;
+        patterns_.push_back({cells, tableOffset});
+        tableSize += 1u << cells.size();
+
+        // Per pattern: another pattern's images read its own table, so they never collide
+        std::vector<std::vector<int>> seen;
+        for (int symmetry = 0; symmetry < 8; ++symmetry) {
+            std::vector<int> mapped(cells.size());
+            for (size_t i = 0; i < cells.size(); ++i) {
+                mapped[i] = transformCell(cells[i], symmetry);
+            }
+            // Symmetric patterns map onto themselves; read each distinct image once
+            if (std::find(seen.begin(), seen.end(), mapped) != seen.end()) continue;
+            seen.push_back(mapped);
+
+            uint64_t mask = 0;
+            for (int cell : mapped) mask |= 1ULL << cell;
+
+            // pext returns bits in ascending square order; remap to the canonical order
+            std::vector<int> sorted = mapped;
+            std::sort(sorted.begin(), sorted.end());
+            const uint32_t permOffset = static_cast<uint32_t>(perms_.size());
+            for (uint32_t x = 0; x < (1u << cells.size()); ++x) {
+                uint16_t index = 0;
+                for (size_t j = 0; j < sorted.size(); ++j) {
+                    if (!(x & (1u << j))) continue;
+                    const size_t i = std::find(mapped.begin(), mapped.end(), sorted[j]) - mapped.begin();
+                    index |= static_cast<uint16_t>(1u << i);
+                }
+                perms_.push_back(index);
+            }
+            images_.push_back({mask, tableOffset, permOffset});
+        }
+    }
+
+    weights_.assign(tableSize, 0.0f);
+    spec_ = spec;
+    return true;
+}
+
+uint32_t NTupleEvaluator::lookupIndex(size_t image, uint64_t board) const {
+    const Image& img = images_[image];
+    return img.tableOffset + perms_[img.permOffset + extractBits(board, img.mask)];
+}
+
+double NTupleEvaluator::evaluate(const Board& board) const {
+    const uint64_t bits = board.data();
+    float value = 0;
+    for (const Image& img : images_) {
+        value += weights_[img.tableOffset + perms_[img.permOffset + extractBits(bits, img.mask)]];
+    }
+    return value;
+}
+
+void NTupleEvaluator::update(const Board& board, double delta) {
+    if (images_.empty()) return;
+    const float step = static_cast<float>(delta / images_.size());
+    const uint64_t bits = board.data();
+    for (size_t i = 0; i < images_.size(); ++i) {
+        weights_[lookupIndex(i, bits)] += step;
+    }
+}
+
+bool NTupleEvaluator::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    const uint32_t specLength = static_cast<uint32_t>(spec_.size());
+    out.write(MAGIC, 4);
+    out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+    out.write(reinterpret_cast<const char*>(&specLength), sizeof(specLength));
+    out.write(spec_.data(), specLength);
+    out.write(reinterpret_cast<const char*>(weights_.data()), weights_.size() * sizeof(float));
+    return static_cast<bool>(out);
+}
+
+bool NTupleEvaluator::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    char magic[4];
+    uint32_t version = 0, specLength = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&specLength), sizeof(specLength));
+    if (!in || std::memcmp(magic, MAGIC, 4) != 0 || version != VERSION || specLength > 4096) return false;
+
+    std::string spec(specLength, '\0');
+    in.read(spec.data(), specLength);
+    NTupleEvaluator loaded(spec);
+    if (!in || loaded.numPatterns() == 0) return false;
+    in.read(reinterpret_cast<char*>(loaded.weights_.data()), loaded.weights_.size() * sizeof(float));
+    if (!in) return false;
+
+    *this = std::move(loaded);
+    return true;
+}
+
+double trainTD0(const std::shared_ptr<NTupleEvaluator>& network, int numGames, double alpha, uint64_t seed) {
+    GreedyStrategy player(network);
+    std::mt19937_64 seedRng(seed);
+    double totalScore = 0;
+
+    for (int g = 0; g < numGames; ++g) {
+        Game game(seedRng());
+        bool havePrevious = false;
+        Board previous;
+
+        while (!game.isGameOver()) {
+            const int before = game.score();
+            player.playTurn(game);
+            const int reward = game.score() - before;
+
+            // The game ending during this hand makes the previous afterstate terminal-adjacent
+            if (havePrevious) {
+                const double target = reward + (game.isGameOver() ? 0.0 : network->evaluate(game.board()));
+                network->update(previous, alpha * (target - network->evaluate(previous)));
+            }
+            previous = game.board();
+            havePrevious = !game.isGameOver();
+        }
+        totalScore += game.score();
+    }
+    return numGames > 0 ? totalScore / numGames : 0;
+}
+
+} // namespace BlockGame
@@ -0,0 +1,175 @@
+#include "perf_counters.hpp"
+#include <cstdio>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace BlockGame {
+
+const char* PerfCounters::eventName(Event event) {
+    switch (event) {
+        case CYCLES: return "cycles";
+        case INSTRUCTIONS: return "instructions";
+        case BRANCH_MISSES: return "branch-misses";
+        case L1D_MISSES: return "L1d-misses";
+        case LLC_MISSES: return "LLC-misses";
+        case DTLB_MISSES: return "dTLB-misses";
+        default: return "?";
+    }
+}
+
+PerfCounters::Reading PerfCounters::Reading::operator-(const Reading& earlier) const {
+    Reading delta;
+    delta.valid = valid & earlier.valid;
+    for (int e = 0; e < NUM_EVENTS; ++e) {
+        delta.counts[e] = counts[e] >= earlier.counts[e] ? counts[e] - earlier.counts[e] : 0;
+    }
+    return delta;
+}
+
+std::string PerfCounters::Reading::describe(double ops, const std::string& unit) const {
+    std::string out;
+    char buf[64];
+    for (int e = 0; e < NUM_EVENTS; ++e) {
+        const Event event = static_cast<Event>(e);
+        if (has(event) && ops > 0) {
+            std::snprintf(buf, sizeof(buf), "%s/%s %.3g", eventName(event), unit.c_str(), counts[e] / ops);
+        } else {
+            std::snprintf(buf, sizeof(buf), "%s/%s n/a", eventName(event), unit.c_str());
+        }
+        out += (e ? "  " : "") + std::string(buf);
+        if (event == INSTRUCTIONS) {
+            if (has(CYCLES) && has(INSTRUCTIONS) && cycles()) {
+                std::snprintf(buf, sizeof(buf), "  IPC %.2f", ipc());
+            } else {
+                std::snprintf(buf, sizeof(buf), "  IPC n/a");
+            }
+            out += buf;
+        }
+    }
+    return out;
+}
+
+#ifdef __linux__
+
+namespace {
+
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+// Cache events: cache id | operation << 8 | result << 16
+constexpr uint64_t cacheReadMiss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+constexpr EventConfig EVENT_CONFIGS[PerfCounters::NUM_EVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_DTLB)},
+};
+
+int openCounter(const EventConfig& event, bool inherit) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.inherit = inherit ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+} // anonymous namespace
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+bool PerfCounters::open(unsigned events, bool inheritThreads) {
+    close();
+    events |= eventBit(CYCLES);
+    for (int e = 0; e < NUM_EVENTS; ++e) {
+        if (!(events & eventBit(static_cast<Event>(e)))) continue;
+        fds_[e] = openCounter(EVENT_CONFIGS[e], inheritThreads);
+        if (e == CYCLES && fds_[e] < 0) {
+            error_ = std::string("perf_event_open: ") + std::strerror(errno);
+            return false;
+        }
+    }
+    error_.clear();
+    return true;
+}
+
+void PerfCounters::close() {
+    for (int& fd : fds_) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+}
+
+void PerfCounters::start() {
+    for (int fd : fds_) {
+        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    }
+    for (int fd : fds_) {
+        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void PerfCounters::stop() {
+    for (int fd : fds_) {
+        if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+}
+
+PerfCounters::Reading PerfCounters::read() const {
+    Reading reading;
+    for (int e = 0; e < NUM_EVENTS; ++e) {
+        if (fds_[e] < 0) continue;
+
+        // value, time_enabled, time_running; never scheduled means nothing was counted
+        uint64_t data[3] = {};
+        if (::read(fds_[e], data, sizeof(data)) < static_cast<ssize_t>(sizeof(data)) || (data[1] && !data[2])) {
+            continue;
+        }
+        const double scale = data[2] ? static_cast<double>(data[1]) / data[2] : 1.0;
+        reading.counts[e] = static_cast<uint64_t>(data[0] * scale);
+        reading.valid |= eventBit(static_cast<Event>(e));
+    }
+    return reading;
+}
+
+#else
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::open(unsigned, bool) {
+    error_ = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+void PerfCounters::close() {}
+void PerfCounters::start() {}
+void PerfCounters::stop() {}
+
+PerfCounters::Reading PerfCounters::read() const {
+    return {};
+}
+
+#endif
+
+} // namespace BlockGame
@@ -1,13 +1,27 @@
 #include "board.hpp"
+#include "perf_counters.hpp"
+#include "perft_cache.hpp"
 #include "pieces.hpp"
 #include <iostream>
 #include <vector>
 #include <chrono>
 #include <iomanip>
+#include <limits>
 #include <map>
 #include <string>
 #include <unordered_map>
 #include <cassert>
+#include <optional>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace BlockGame;
 
@@ -17,30 +31,190 @@ enum class Mode {
     NEARFULL
 };
 
-struct TranspositionTable {
+// Node counts are uint64_t by default and unsigned __int128 with --count 128,
+// for depths whose totals no longer fit. Every sum and product is checked, so
+// an overflow stops the search instead of wrapping to a plausible wrong count.
+using uint128 = unsigned __int128;
+
+template <typename Count>
+constexpr int countBits() {
+    return static_cast<int>(sizeof(Count) * 8);
+}
+
+// False on overflow
+template <typename Count>
+bool addCount(Count& total, Count value) {
+    return !__builtin_add_overflow(total, value, &total);
+}
+
+template <typename Count>
+bool mulCount(Count& product, Count a, Count b) {
+    return !__builtin_mul_overflow(a, b, &product);
+}
+
+// Decimal, since iostreams cannot print __int128
+template <typename Count>
+std::string formatCount(Count value) {
+    std::string digits;
+    do {
+        digits += static_cast<char>('0' + static_cast<int>(value % 10));
+        value /= 10;
+    } while (value);
+    return {digits.rbegin(), digits.rend()};
+}
+
+template <typename Count>
+bool parseCount(const std::string& text, Count& value) {
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9' || !mulCount(value, value, Count{10}) || !addCount(value, static_cast<Count>(c - '0'))) {
+            return false;
+        }
+    }
+    return !text.empty();
+}
+
+// The parts of the table that do not depend on the count type, for progress reports
+struct TranspositionTableBase {
+    // Optional second level shared across runs, keyed by remaining depth
+    constexpr static int FILE_MIN_REMAINING = 2;   // Shallower subtrees are cheaper to recount than to page in
+    PerftCache* file = nullptr;
+
+    size_t entries = 0;
+
+    // Lookup statistics for progress reports
+    mutable uint64_t probes = 0;
+    mutable uint64_t hits = 0;
+    mutable uint64_t fileHits = 0;
+
+    [[nodiscard]] size_t size() const {
+        return entries;
+    }
+
+    // Statistics are per depth, the entries are kept
+    void resetStats() {
+        probes = 0;
+        hits = 0;
+        fileHits = 0;
+    }
+};
+
+template <typename Count>
+struct TranspositionTable : TranspositionTableBase {
     // Map from board hash to terminal node count
-    // One for each depth, up to a fixed max depth
-    constexpr static int MAX_DEPTH = 8;
-    std::array<std::unordered_map<uint64_t, uint64_t>, MAX_DEPTH> tables;
+    // One per remaining depth (max depth - depth), grown as deeper searches need them.
+    // A subtree's count only depends on the board and the plies left, so entries stay
+    // valid from one max depth to the next and the table is kept for the whole run.
+    std::vector<std::unordered_map<uint64_t, Count>> tables;
 
-    [[nodiscard]] int64_t query(uint64_t board_hash, int depth) const {
-        assert (depth >= 0 && depth < static_cast<int>(tables.size()));
-        auto it = tables[depth].find(board_hash);
-        if (it != tables[depth].end()) {
-            return it->second;
+    [[nodiscard]] bool query(uint64_t board_hash, int remaining, Count& count) const {
+        assert (remaining >= 0);
+        probes++;
+        if (remaining >= static_cast<int>(tables.size())) {
+            return false;
         }
-        return -1;
+        auto it = tables[remaining].find(board_hash);
+        if (it != tables[remaining].end()) {
+            hits++;
+            count = it->second;
+            return true;
+        }
+        return false;
     }
 
-    void store(uint64_t board_hash, int depth, uint64_t count) {
-        assert (depth >= 0 && depth < static_cast<int>(tables.size()));
-        tables[depth][board_hash] = count;
+    void store(uint64_t board_hash, int remaining, Count count) {
+        assert (remaining >= 0);
+        if (remaining >= static_cast<int>(tables.size())) {
+            tables.resize(remaining + 1);
+        }
+        entries += tables[remaining].insert_or_assign(board_hash, count).second;
+    }
+};
+
+// Progress reporting and the time limit. The search checks the clock every
+// POLL_INTERVAL calls; once the deadline passes, or a count overflows, it
+// unwinds without storing anything, so the table only ever holds complete
+// subtree counts.
+struct SearchMonitor {
+    using Clock = std::chrono::steady_clock;
+    constexpr static uint64_t POLL_INTERVAL = 1 << 14;
+
+    std::optional<Clock::time_point> deadline;
+    double progressInterval = 0;    // Seconds between reports, 0 = none
+    const TranspositionTableBase* tt = nullptr;
+    std::function<void()> onPoll;   // E.g. a distributed worker's heartbeat
+
+    // Current depth
+    int depth = 0;
+    Clock::time_point depthStart;
+    Clock::time_point nextReport;
+    uint64_t calls = 0;             // countTerminalNodes calls above max depth, including table hits
+    uint64_t nextPoll = POLL_INTERVAL;
+    size_t rootsDone = 0;
+    size_t rootsTotal = 0;
+    double terminalsDone = 0;       // Terminal nodes under the finished root moves
+    bool stopped = false;
+    bool overflowed = false;        // Stopped because a count did not fit the count type
+
+    void beginDepth(int d) {
+        depth = d;
+        depthStart = Clock::now();
+        nextReport = depthStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(progressInterval));
+        calls = 0;
+        nextPoll = POLL_INTERVAL;
+        rootsDone = 0;
+        rootsTotal = 0;
+        terminalsDone = 0;
+    }
+
+    void overflow() {
+        overflowed = true;
+        stopped = true;
+    }
+
+    // Counts a call, returns false once the search must stop
+    bool visit() {
+        if (++calls >= nextPoll) poll();
+        return !stopped;
+    }
+
+    void poll() {
+        nextPoll = calls + POLL_INTERVAL;
+        if (onPoll) {
+            onPoll();
+        }
+        const auto now = Clock::now();
+        if (deadline && now >= *deadline) {
+            stopped = true;
+            return;
+        }
+        if (progressInterval > 0 && now >= nextReport) {
+            report(now);
+            nextReport = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(progressInterval));
+        }
     }
 
-    void clear() {
-        for (auto& table : tables) {
-            table.clear();
+    // One progress line on stderr; the ETA assumes the remaining root moves cost as much as the finished ones
+    void report(Clock::time_point now) const {
+        const double elapsed = std::chrono::duration<double>(now - depthStart).count();
+        const double fraction = rootsTotal ? static_cast<double>(rootsDone) / rootsTotal : 0.0;
+        std::ostringstream line;
+        line << std::setprecision(3) << "  [depth " << depth << "] " << elapsed << "s  roots " << rootsDone << "/"
+             << rootsTotal << " (" << 100.0 * fraction << "%)  terminal " << terminalsDone
+             << "  calls " << static_cast<double>(calls) << " (" << calls / std::max(elapsed, 1e-9) << "/s)";
+        if (tt) {
+            line << "  TT " << tt->size() << " entries, "
+                 << (tt->probes ? 100.0 * tt->hits / tt->probes : 0.0) << "% hits";
+            if (tt->file) {
+                line << ", " << static_cast<double>(tt->fileHits) << " file hits";
+            }
         }
+        if (fraction > 0) {
+            line << "  ETA " << elapsed * (1 - fraction) / fraction << "s";
+        } else {
+            line << "  ETA ?";
+        }
+        std::cerr << line.str() << "\n" << std::flush;
     }
 };
 
@@ -48,20 +222,34 @@ struct TranspositionTable {
 // A node is terminal if:
 // 1. depth == max_depth
 // 2. OR no legal moves possible from current state (game over)
-uint64_t countTerminalNodes(const Board& board, int depth, int max_depth, const std::vector<Piece>& pieces, TranspositionTable& tt) {
+// Returns 0 without touching the table if the monitor stops the search.
+template <typename Count>
+Count countTerminalNodes(const Board& board, int depth, int max_depth, const std::vector<Piece>& pieces,
+                         TranspositionTable<Count>& tt, SearchMonitor& monitor) {
     // If max depth reached, this path ends here.
     if (depth == max_depth) {
         return 1;
     }
 
-    if (depth < TranspositionTable::MAX_DEPTH) {
-        const int64_t tt_result = tt.query(board.data(), depth);
-        if (tt_result != -1) {
-            return tt_result;
-        }
+    if (!monitor.visit()) {
+        return 0;
+    }
+
+    const int remaining = max_depth - depth;
+    Count tt_result = 0;
+    if (tt.query(board.data(), remaining, tt_result)) {
+        return tt_result;
+    }
+
+    const bool use_file = tt.file && remaining >= TranspositionTableBase::FILE_MIN_REMAINING;
+    uint64_t file_count = 0;
+    if (use_file && tt.file->probe(board.data(), remaining, file_count)) {
+        tt.fileHits++;
+        tt.store(board.data(), remaining, file_count);
+        return file_count;
     }
 
-    uint64_t total_terminal_nodes = 0;
+    Count total_terminal_nodes = 0;
 
     // Try all pieces
     for (const auto& piece : pieces) {
@@ -76,7 +264,14 @@ uint64_t countTerminalNodes(const Board& board, int depth, int max_depth, const
                     Board next_board = board;
                     next_board.placeAndClear(mask);
                     
-                    total_terminal_nodes += countTerminalNodes(next_board, depth + 1, max_depth, pieces, tt);
+                    const Count child = countTerminalNodes(next_board, depth + 1, max_depth, pieces, tt, monitor);
+                    if (monitor.stopped) {
+                        return 0;
+                    }
+                    if (!addCount(total_terminal_nodes, child)) {
+                        monitor.overflow();
+                        return 0;
+                    }
                 }
             }
         }
@@ -87,52 +282,752 @@ uint64_t countTerminalNodes(const Board& board, int depth, int max_depth, const
         total_terminal_nodes = 1;
     }
     
-    if (depth < TranspositionTable::MAX_DEPTH) {
-        tt.store(board.data(), depth, total_terminal_nodes);
+    tt.store(board.data(), remaining, total_terminal_nodes);
+    // The file holds counts up to PerftCache::MAX_COUNT, larger ones are recounted
+    if (use_file && total_terminal_nodes <= PerftCache::MAX_COUNT) {
+        tt.file->store(board.data(), remaining, static_cast<uint64_t>(total_terminal_nodes));
     }
 
     return total_terminal_nodes;
 }
 
-int main(int argc, char* argv[]) {
-    int max_depth_limit = 2; // Default
-    Mode mode = Mode::DEFAULT;
-    std::string modeStr = "default";
+template <typename Count>
+struct RootCount {
+    PieceType type;
+    int row;
+    int col;
+    Count count;
+};
+
+// Same count as countTerminalNodes from the root, one root move at a time, so
+// a run stopped by the time limit can still report every finished root move
+template <typename Count>
+Count countByRootMove(const Board& board, int max_depth, const std::vector<Piece>& pieces, TranspositionTable<Count>& tt,
+                      SearchMonitor& monitor, std::vector<RootCount<Count>>& finished) {
+    finished.clear();
+    if (max_depth == 0) {
+        return 1;
+    }
+
+    std::vector<Move> rootMoves;
+    for (const auto& piece : pieces) {
+        for (int row = 0; row < piece.shiftTable.maxRow + 1; ++row) {
+            for (int col = 0; col < piece.shiftTable.maxCol + 1; ++col) {
+                const uint64_t mask = piece.shiftToUnsafe(row, col);
+                if (board.canPlace(mask)) {
+                    rootMoves.push_back({piece.type, row, col, mask});
+                }
+            }
+        }
+    }
+    if (rootMoves.empty()) {
+        return 1;
+    }
+
+    monitor.rootsTotal = rootMoves.size();
+    Count total = 0;
+    for (const Move& move : rootMoves) {
+        Board next_board = board;
+        next_board.placeAndClear(move.mask);
+        const Count count = countTerminalNodes(next_board, 1, max_depth, pieces, tt, monitor);
+        if (monitor.stopped) {
+            break;
+        }
+        finished.push_back({move.type, move.row, move.col, count});
+        if (!addCount(total, count)) {
+            monitor.overflow();
+            break;
+        }
+        monitor.rootsDone++;
+        monitor.terminalsDone = static_cast<double>(total);
+    }
+    return total;
+}
+
+// ---------------------------------------------------------------------------
+// Positions
+//
+// A perft can start from any board, optionally with a hand: without one every
+// piece may be placed at every ply, as in the built-in modes; with one each ply
+// places one of the hand's pieces not yet used, so the tree ends when the hand
+// is used up or nothing fits. A batch file lists positions EPD style, one per
+// line, with the expected count at each depth:
+//
+//   # board            hand (- = every piece)   expected counts
+//   0x0000000000000000 -                        ;D1 1421 ;D2 1617196
+//   0x00003c3c3c3c0000 3x3_square,1x5_line,4   ;D1 40 ;D2 696 ;D3 696
+//
+// Pieces are given by index (0 to NUM_PIECES-1) or by display name in lower case with
+// everything but letters and digits replaced by '_' (e.g. "l_piece_90").
+// ---------------------------------------------------------------------------
+
+struct Position {
+    Board board;
+    std::vector<PieceType> hand;
+    std::map<int, uint128> expected;        // Depth -> count, from a batch file
+    int line = 0;
+};
+
+// Display name as accepted on the command line, e.g. "S piece 90° Mirrored" -> "s_piece_90_mirrored"
+std::string pieceKey(const Piece& piece) {
+    std::string key;
+    for (unsigned char ch : piece.name) {
+        if (std::isalnum(ch)) {
+            key += static_cast<char>(std::tolower(ch));
+        } else if (!key.empty() && key.back() != '_') {
+            key += '_';
+        }
+    }
+    while (!key.empty() && key.back() == '_') {
+        key.pop_back();
+    }
+    return key;
+}
+
+bool parseHand(const std::string& text, std::vector<PieceType>& hand) {
+    hand.clear();
+    if (text == "-") {
+        return true;
+    }
+    std::stringstream in(text);
+    std::string token;
+    while (std::getline(in, token, ',')) {
+        bool found = false;
+        for (const Piece& piece : getAllPieces()) {
+            if (token == pieceKey(piece) || token == std::to_string(piece.type)) {
+                hand.push_back(piece.type);
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            std::cerr << "Unknown piece: " << token << "\n";
+            return false;
+        }
+    }
+    return !hand.empty();
+}
+
+std::string formatHand(const std::vector<PieceType>& hand) {
+    if (hand.empty()) {
+        return "-";
+    }
+    std::string text;
+    for (PieceType type : hand) {
+        if (!text.empty()) {
+            text += ',';
+        }
+        text += pieceKey(getPiece(type));
+    }
+    return text;
+}
 
-    if (argc > 1) {
+std::string formatBoard(const Board& board) {
+    std::ostringstream out;
+    out << "0x" << std::hex << std::setw(16) << std::setfill('0') << board.data();
+    return out.str();
+}
+
+// Terminal nodes when each ply places one of the unused hand pieces. Two
+// pieces of the same type make the same moves, so only the first is tried.
+// Hands are short, so there is no table.
+template <typename Count>
+Count countHandNodes(const Board& board, std::vector<PieceType>& hand, int depth, int max_depth, SearchMonitor& monitor) {
+    if (depth == max_depth) {
+        return 1;
+    }
+
+    if (!monitor.visit()) {
+        return 0;
+    }
+
+    Count total = 0;
+    for (size_t i = 0; i < hand.size(); ++i) {
+        if (std::find(hand.begin(), hand.begin() + i, hand[i]) != hand.begin() + i) {
+            continue;
+        }
+        const Piece& piece = getPiece(hand[i]);
+        std::swap(hand[i], hand.back());
+        hand.pop_back();
+        for (int row = 0; row < piece.shiftTable.maxRow + 1; ++row) {
+            for (int col = 0; col < piece.shiftTable.maxCol + 1; ++col) {
+                const uint64_t mask = piece.shiftToUnsafe(row, col);
+                if (board.canPlace(mask)) {
+                    Board next_board = board;
+                    next_board.placeAndClear(mask);
+                    const Count child = countHandNodes<Count>(next_board, hand, depth + 1, max_depth, monitor);
+                    if (!monitor.stopped && !addCount(total, child)) {
+                        monitor.overflow();
+                    }
+                }
+            }
+        }
+        hand.push_back(piece.type);
+        std::swap(hand[i], hand.back());
+        if (monitor.stopped) {
+            return 0;
+        }
+    }
+
+    // Hand used up or nothing fits
+    if (total == 0) {
+        total = 1;
+    }
+    return total;
+}
+
+// Returns false, after reporting the line, if the file cannot be read or a line is malformed
+bool readBatch(const std::string& path, std::vector<Position>& positions) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Error: cannot open " << path << "\n";
+        return false;
+    }
+    std::string text;
+    for (int line = 1; std::getline(in, text); ++line) {
+        const size_t comment = text.find('#');
+        if (comment != std::string::npos) {
+            text.erase(comment);
+        }
+        std::stringstream fields(text);
+        std::string boardText, handText;
+        if (!(fields >> boardText)) {
+            continue;   // Blank or comment
+        }
+
+        Position position;
+        position.line = line;
+        bool ok = static_cast<bool>(fields >> handText);
         try {
-            max_depth_limit = std::stoi(argv[1]);
+            position.board = Board(std::stoull(boardText, nullptr, 16));
         } catch (...) {
-            std::cerr << "Invalid argument for max depth\n";
-            return 1;
+            ok = false;
+        }
+        ok = ok && parseHand(handText, position.hand);
+
+        // ";D<depth> <count>" operations
+        std::string op, count;
+        while (ok && fields >> op) {
+            int depth = -1;
+            uint128 value = 0;
+            try {
+                depth = op.rfind(";D", 0) == 0 ? std::stoi(op.substr(2)) : -1;
+            } catch (...) {
+            }
+            ok = depth >= 0 && fields >> count && parseCount(count, value);
+            if (ok && !position.expected.emplace(depth, value).second) {
+                std::cerr << path << ":" << line << ": depth " << depth << " is given twice\n";
+                return false;
+            }
         }
+        if (!ok || position.expected.empty()) {
+            std::cerr << path << ":" << line << ": expected \"<board hex> <hand|-> ;D<depth> <count> ...\"\n";
+            return false;
+        }
+        positions.push_back(std::move(position));
     }
-    
-    if (argc > 2) {
-        modeStr = argv[2];
-        if (modeStr == "nearfull") {
-            mode = Mode::NEARFULL;
-        } else if (modeStr != "default") {
-            std::cerr << "Unknown mode: " << modeStr << ". Using default.\n";
-            modeStr = "default";
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Distributed perft
+//
+// The coordinator expands the tree to the split depth, merges identical boards
+// (keeping how many move paths reach each) and writes them as task files into a
+// shared work directory:
+//
+//   DIR/job         what is being counted; workers wait for it to appear
+//   DIR/pending/    tasks nobody has claimed
+//   DIR/running/    claimed tasks; the claimant touches the file as a heartbeat
+//   DIR/done/       one result file per finished task
+//   DIR/complete    written by the coordinator once every result is in
+//
+// Workers claim a task by renaming it from pending/ to running/, which only one
+// of them can win, and publish the result with a rename, so a crash never
+// leaves a half-written file behind. The coordinator moves running tasks whose
+// heartbeat is older than the lease back to pending/, so a killed or restarted
+// worker only costs its current task. A late result from a worker presumed dead
+// is identical to the retry's, and the total is a sum of integers, so it does
+// not depend on which worker did what or in which order. The job fixes the
+// count type and the lease, so every worker heartbeats in time for the
+// coordinator; a task whose count overflows reports that instead of a number.
+// ---------------------------------------------------------------------------
+
+namespace fs = std::filesystem;
+
+struct DistributedJob {
+    uint64_t board = 0;
+    int depth = 0;
+    int split = 0;
+    int tasks = 0;
+    int countBits = 64;
+    uint64_t direct = 0;    // Terminal nodes above the split depth (games that ended early)
+    double lease = 30;      // Seconds without a heartbeat before the coordinator requeues a task
+
+    // The lease is not part of the work: a resumed job keeps the one it was started with
+    bool operator==(const DistributedJob& other) const {
+        return board == other.board && depth == other.depth && split == other.split && tasks == other.tasks &&
+               countBits == other.countBits && direct == other.direct;
+    }
+};
+
+struct DistributedOptions {
+    fs::path dir;
+    int split = 2;
+    int tasks = 256;
+    int workers = 0;        // Local worker processes the coordinator forks
+    double lease = 30;      // Seconds without a heartbeat before a task is handed out again
+};
+
+std::string taskName(int index) {
+    std::ostringstream name;
+    name << "task-" << std::setw(6) << std::setfill('0') << index;
+    return name.str();
+}
+
+// Write to a temporary name and rename, so readers only ever see complete files
+bool writeAtomically(const fs::path& path, const std::string& content) {
+    const fs::path tmp = path.string() + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(tmp);
+        if (!(out << content) || !out.flush()) {
+            return false;
         }
     }
-    
-    std::cout << "Running Perft (Terminal Node Count)\n";
-    std::cout << "  Max Depth: " << max_depth_limit << "\n";
-    std::cout << "  Mode:      " << modeStr << "\n\n";
-    
-    // Initialize board based on mode
-    Board initialBoard;
-    if (mode == Mode::NEARFULL) {
-        // Fill all but top/bottom row and left/right col
-        // Rows 1-6, Cols 1-6
-        for (int r = 1; r <= 6; ++r) {
-            for (int c = 1; c <= 6; ++c) {
-                initialBoard.setOccupied(r, c);
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+bool writeJob(const fs::path& path, const DistributedJob& job) {
+    std::ostringstream out;
+    out << "perft-job 3\n" << "board 0x" << std::hex << job.board << std::dec << "\n" << "depth " << job.depth << "\n"
+        << "split " << job.split << "\n" << "tasks " << job.tasks << "\n" << "count " << job.countBits << "\n"
+        << "direct " << job.direct << "\n" << "lease " << std::setprecision(std::numeric_limits<double>::max_digits10) << job.lease << "\n";
+    return writeAtomically(path, out.str());
+}
+
+bool readJob(const fs::path& path, DistributedJob& job) {
+    std::ifstream in(path);
+    std::string magic, key;
+    int version = 0;
+    if (!(in >> magic >> version) || magic != "perft-job" || version != 3) {
+        return false;
+    }
+    in >> key >> std::hex >> job.board >> std::dec;
+    in >> key >> job.depth >> key >> job.split >> key >> job.tasks >> key >> job.countBits >> key >> job.direct;
+    in >> key >> job.lease;
+    return in && job.lease > 0;
+}
+
+// Every board at the split depth with the number of move paths reaching it.
+// Games that end before the split are terminal nodes, counted in direct.
+void expandToSplit(const Board& board, int depth, int split, const std::vector<Piece>& pieces,
+                   std::unordered_map<uint64_t, uint64_t>& frontier, uint64_t& direct) {
+    if (depth == split) {
+        frontier[board.data()]++;
+        return;
+    }
+    bool any = false;
+    for (const auto& piece : pieces) {
+        for (int row = 0; row < piece.shiftTable.maxRow + 1; ++row) {
+            for (int col = 0; col < piece.shiftTable.maxCol + 1; ++col) {
+                const uint64_t mask = piece.shiftToUnsafe(row, col);
+                if (board.canPlace(mask)) {
+                    Board next_board = board;
+                    next_board.placeAndClear(mask);
+                    expandToSplit(next_board, depth + 1, split, pieces, frontier, direct);
+                    any = true;
+                }
+            }
+        }
+    }
+    if (!any) {
+        direct++;
+    }
+}
+
+// Claims and counts tasks until the coordinator marks the job complete
+template <typename Count>
+int runTasks(const fs::path& dir, PerftCache* ttFile, double lease) {
+    const auto& pieces = getAllPieces();
+    TranspositionTable<Count> tt;
+    tt.file = ttFile;
+    const std::string self = "worker " + std::to_string(getpid());
+
+    while (true) {
+        std::error_code ec;
+        std::vector<fs::path> pending;
+        for (const auto& entry : fs::directory_iterator(dir / "pending", ec)) {
+            const std::string name = entry.path().filename().string();
+            if (name.rfind("task-", 0) == 0 && name.find(".tmp.") == std::string::npos) {
+                pending.push_back(entry.path());
+            }
+        }
+        std::sort(pending.begin(), pending.end());
+
+        bool claimed = false;
+        for (const fs::path& task : pending) {
+            const fs::path running = dir / "running" / task.filename();
+            fs::rename(task, running, ec);
+            if (ec) {
+                continue;   // Another worker got it first
+            }
+            claimed = true;
+
+            std::ifstream in(running);
+            int remaining = 0;
+            std::string key;
+            in >> key >> remaining;
+            std::vector<std::pair<uint64_t, uint64_t>> boards;
+            uint64_t board = 0;
+            uint64_t paths = 0;
+            while (in >> std::hex >> board >> std::dec >> paths) {
+                boards.push_back({board, paths});
+            }
+            if (key != "remaining") {
+                std::cerr << self << ": cannot read " << running.string() << "\n";
+                return 1;
+            }
+
+            // Heartbeat: refresh the claim's mtime well within the job's lease. The rename kept
+            // the time the coordinator wrote the task, so start with a fresh one.
+            auto lastTouch = SearchMonitor::Clock::now();
+            auto heartbeat = [&](bool force) {
+                const auto now = SearchMonitor::Clock::now();
+                if (force || std::chrono::duration<double>(now - lastTouch).count() > lease / 4) {
+                    std::error_code touchError;
+                    fs::last_write_time(running, fs::file_time_type::clock::now(), touchError);
+                    lastTouch = now;
+                }
+            };
+            heartbeat(true);
+            SearchMonitor monitor;
+            monitor.onPoll = [&] { heartbeat(false); };
+            monitor.beginDepth(remaining);
+
+            const auto start = SearchMonitor::Clock::now();
+            Count count = 0;
+            for (const auto& [b, n] : boards) {
+                const Count subtree = countTerminalNodes(Board(b), 0, remaining, pieces, tt, monitor);
+                Count paths = 0;
+                if (monitor.overflowed || !mulCount(paths, static_cast<Count>(n), subtree) || !addCount(count, paths)) {
+                    monitor.overflow();
+                    break;
+                }
+                heartbeat(false);
+            }
+            const double seconds = std::chrono::duration<double>(SearchMonitor::Clock::now() - start).count();
+
+            std::ostringstream result;
+            result << "boards " << boards.size() << "\ncount "
+                   << (monitor.overflowed ? std::string("overflow") : formatCount(count)) << "\n";
+            if (!writeAtomically(dir / "done" / task.filename(), result.str())) {
+                std::cerr << self << ": cannot write result for " << task.filename().string() << "\n";
+                return 1;
+            }
+            fs::remove(running, ec);
+            std::cerr << self << ": " << task.filename().string() << " (" << boards.size() << " boards) in "
+                      << std::fixed << std::setprecision(2) << seconds << "s\n";
+            break;      // Rescan, the coordinator may have requeued tasks meanwhile
+        }
+
+        if (!claimed) {
+            if (fs::exists(dir / "complete")) {
+                return 0;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+    }
+}
+
+// A worker heartbeats against the lease in the job file; a --lease given on its
+// own command line must agree with it
+int runWorker(const fs::path& dir, PerftCache* ttFile, std::optional<double> lease) {
+    DistributedJob job;
+    while (!readJob(dir / "job", job)) {
+        if (fs::exists(dir / "complete")) {
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    if (lease && *lease != job.lease) {
+        std::cerr << "Error: --lease " << *lease << " does not match the job's lease of " << job.lease << "s\n";
+        return 1;
+    }
+    return job.countBits == 128 ? runTasks<uint128>(dir, ttFile, job.lease)
+                                : runTasks<uint64_t>(dir, ttFile, job.lease);
+}
+
+pid_t forkWorker(const fs::path& dir, PerftCache* ttFile) {
+    std::cout << std::flush;
+    const pid_t pid = fork();
+    if (pid == 0) {
+        _exit(runWorker(dir, ttFile, std::nullopt));
+    }
+    return pid;
+}
+
+// Splits the job into tasks, runs local workers if asked, waits for every
+// result and returns the total. Resumes a job already in the directory.
+template <typename Count>
+bool runCoordinator(const Board& board, int depth, const DistributedOptions& options, PerftCache* ttFile,
+                    double progressInterval, Count& total, bool& overflowed) {
+    const auto& pieces = getAllPieces();
+    std::error_code ec;
+    for (const char* sub : {"pending", "running", "done"}) {
+        fs::create_directories(options.dir / sub, ec);
+        if (ec) {
+            std::cerr << "Error: cannot create " << (options.dir / sub).string() << ": " << ec.message() << "\n";
+            return false;
+        }
+    }
+
+    std::unordered_map<uint64_t, uint64_t> frontier;
+    DistributedJob job;
+    job.board = board.data();
+    job.depth = depth;
+    job.split = options.split;
+    job.countBits = countBits<Count>();
+    job.lease = options.lease;
+    expandToSplit(board, 0, options.split, pieces, frontier, job.direct);
+    job.tasks = static_cast<int>(std::min<size_t>(options.tasks, frontier.size()));
+
+    DistributedJob existing;
+    if (fs::exists(options.dir / "job")) {
+        if (!readJob(options.dir / "job", existing) || !(existing == job)) {
+            std::cerr << "Error: " << options.dir.string() << " holds a different job\n";
+            return false;
+        }
+        std::cout << "Resuming job in " << options.dir.string() << "\n";
+        if (existing.lease != job.lease) {
+            std::cout << "Keeping the job's lease of " << existing.lease << "s\n";
+        }
+        job.lease = existing.lease;
+    } else {
+        // Sorted so the same job always produces the same tasks
+        std::vector<std::pair<uint64_t, uint64_t>> boards(frontier.begin(), frontier.end());
+        std::sort(boards.begin(), boards.end());
+        const size_t perTask = job.tasks ? (boards.size() + job.tasks - 1) / job.tasks : 0;
+        for (int t = 0; t < job.tasks; ++t) {
+            std::ostringstream task;
+            task << "remaining " << depth - options.split << "\n" << std::hex;
+            const size_t end = std::min(boards.size(), (t + 1) * perTask);
+            for (size_t i = t * perTask; i < end; ++i) {
+                task << boards[i].first << " " << std::dec << boards[i].second << std::hex << "\n";
+            }
+            if (!writeAtomically(options.dir / "pending" / taskName(t), task.str())) {
+                std::cerr << "Error: cannot write tasks to " << options.dir.string() << "\n";
+                return false;
+            }
+        }
+        fs::remove(options.dir / "complete", ec);
+        if (!writeJob(options.dir / "job", job)) {
+            std::cerr << "Error: cannot write " << (options.dir / "job").string() << "\n";
+            return false;
+        }
+    }
+    std::cout << "Split at depth " << options.split << ": " << frontier.size() << " boards in " << job.tasks
+              << " tasks, " << job.direct << " earlier terminal nodes\n";
+
+    std::vector<pid_t> children;
+    for (int w = 0; w < options.workers; ++w) {
+        children.push_back(forkWorker(options.dir, ttFile));
+    }
+
+    const auto start = SearchMonitor::Clock::now();
+    auto nextReport = start;
+    while (true) {
+        int done = 0;
+        for (int t = 0; t < job.tasks; ++t) {
+            done += fs::exists(options.dir / "done" / taskName(t));
+        }
+        if (done == job.tasks) {
+            break;
+        }
+
+        // Hand out tasks again whose worker stopped sending heartbeats
+        const auto now = fs::file_time_type::clock::now();
+        for (const auto& entry : fs::directory_iterator(options.dir / "running", ec)) {
+            std::error_code timeError;
+            const auto touched = fs::last_write_time(entry.path(), timeError);
+            if (!timeError && std::chrono::duration<double>(now - touched).count() > job.lease &&
+                !fs::exists(options.dir / "done" / entry.path().filename())) {
+                std::cerr << "Requeueing " << entry.path().filename().string() << " (no heartbeat)\n";
+                fs::rename(entry.path(), options.dir / "pending" / entry.path().filename(), timeError);
+            }
+        }
+
+        // Replace local workers that died
+        int status = 0;
+        pid_t exited;
+        while ((exited = waitpid(-1, &status, WNOHANG)) > 0) {
+            auto it = std::find(children.begin(), children.end(), exited);
+            if (it != children.end()) {
+                std::cerr << "Worker " << exited << " exited, restarting\n";
+                *it = forkWorker(options.dir, ttFile);
             }
         }
+
+        if (progressInterval > 0 && SearchMonitor::Clock::now() >= nextReport) {
+            const double elapsed = std::chrono::duration<double>(SearchMonitor::Clock::now() - start).count();
+            std::cerr << "  [distributed] " << std::fixed << std::setprecision(1) << elapsed << "s  tasks " << done
+                      << "/" << job.tasks << "\n";
+            nextReport += std::chrono::duration_cast<SearchMonitor::Clock::duration>(std::chrono::duration<double>(progressInterval));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    bool ok = true;
+    overflowed = false;
+    total = job.direct;
+    for (int t = 0; t < job.tasks; ++t) {
+        std::ifstream in(options.dir / "done" / taskName(t));
+        std::string key, value;
+        size_t numBoards = 0;
+        Count count = 0;
+        if (!(in >> key >> numBoards >> key >> value)) {
+            std::cerr << "Error: bad result file for " << taskName(t) << "\n";
+            ok = false;
+        } else if (value != "overflow" && !parseCount(value, count)) {
+            std::cerr << "Error: bad count in the result for " << taskName(t) << "\n";
+            ok = false;
+        } else if (value == "overflow" || !addCount(total, count)) {
+            overflowed = true;
+        }
+    }
+
+    writeAtomically(options.dir / "complete", "done\n");
+    for (pid_t child : children) {
+        waitpid(child, nullptr, 0);
     }
+    return ok;
+}
+
+void printUsage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [max depth] [default|nearfull] [options]\n";
+    std::cerr << "  --board HEX          Start from this board (bit row * 8 + col) instead of the mode's\n";
+    std::cerr << "  --hand A,B,C         Each ply places one unused piece of this hand, by index or\n";
+    std::cerr << "                       name (e.g. 3x3_square,l_piece_90), instead of any piece\n";
+    std::cerr << "  --batch FILE         Check every position of an EPD-style file:\n";
+    std::cerr << "                       \"<board hex> <hand|-> ;D1 <count> ;D2 <count> ...\"\n";
+    std::cerr << "  --jobs N             Batch positions run in parallel (default: hardware threads)\n";
+    std::cerr << "  --count 64|128       Width of the node counts; a count that overflows stops the\n";
+    std::cerr << "                       run with an error (default: 64)\n";
+    std::cerr << "  --perf-counters      Report hardware counters per node for each depth\n";
+    std::cerr << "  --progress SECONDS   Progress line on stderr this often, 0 = never (default: 10)\n";
+    std::cerr << "  --time-limit SECONDS Stop cleanly after this long and report the finished root\n";
+    std::cerr << "                       moves of the unfinished depth (default: no limit)\n";
+    std::cerr << "  --tt-file PATH       Keep subtree counts in a memory-mapped file shared by runs\n";
+    std::cerr << "                       and concurrent processes, created if missing\n";
+    std::cerr << "  --tt-file-bits N     Table size 2^N entries of 16 bytes for a new file, 1-34 (default: 22)\n";
+    std::cerr << "\nDistributed (max depth only, workers share a directory):\n";
+    std::cerr << "  --distribute DIR     Coordinate: split the tree into tasks in DIR and sum the results\n";
+    std::cerr << "  --split K            Depth of the task boards (default: 2, at most max depth - 1)\n";
+    std::cerr << "  --tasks N            Number of task files (default: 256)\n";
+    std::cerr << "  --workers N          Local worker processes to start and restart (default: 0)\n";
+    std::cerr << "  --lease SECONDS      Requeue a task after this long without a heartbeat (default: 30),\n";
+    std::cerr << "                       recorded in the job; a worker's --lease must match it\n";
+    std::cerr << "  --worker DIR         Work on the tasks in DIR until the job completes\n";
+}
+
+struct PerftOptions {
+    int maxDepth = 2;
+    std::string modeStr = "default";
+    bool perfCounters = false;
+    double progressInterval = 10;
+    double timeLimit = 0;
+    PerftCache* ttFile = nullptr;
+    std::vector<PieceType> hand;        // Empty: every piece at every ply
+    DistributedOptions distributed;     // Coordinate a distributed run if dir is set
+};
+
+// Runs every position of a batch to each depth it lists, jobs positions at a
+// time with a table each, and prints the results in file order
+template <typename Count>
+int runBatch(const std::vector<Position>& positions, const PerftOptions& options, int jobs) {
+    struct Result {
+        std::string text;
+        bool passed = true;
+    };
+    std::vector<Result> results(positions.size());
+    std::optional<SearchMonitor::Clock::time_point> deadline;
+    if (options.timeLimit > 0) {
+        deadline = SearchMonitor::Clock::now() +
+                   std::chrono::duration_cast<SearchMonitor::Clock::duration>(std::chrono::duration<double>(options.timeLimit));
+    }
+
+    auto runPosition = [&](const Position& position, Result& result) {
+        const auto& pieces = getAllPieces();
+        TranspositionTable<Count> tt;
+        tt.file = options.ttFile;
+        SearchMonitor monitor;
+        monitor.deadline = deadline;
+        std::vector<PieceType> hand = position.hand;
+
+        std::ostringstream out;
+        out << "line " << std::setw(3) << position.line << "  " << formatBoard(position.board) << " "
+            << formatHand(position.hand) << "\n";
+        for (const auto& [depth, expected] : position.expected) {
+            const auto start = SearchMonitor::Clock::now();
+            monitor.beginDepth(depth);
+            const Count count = hand.empty() ? countTerminalNodes(position.board, 0, depth, pieces, tt, monitor)
+                                             : countHandNodes<Count>(position.board, hand, 0, depth, monitor);
+            const double seconds = std::chrono::duration<double>(SearchMonitor::Clock::now() - start).count();
+
+            out << "  D" << depth << ": ";
+            if (monitor.overflowed) {
+                out << "count overflows " << countBits<Count>() << " bits [FAIL]\n";
+                result.passed = false;
+                break;
+            }
+            if (monitor.stopped) {
+                out << "stopped by time limit [FAIL]\n";
+                result.passed = false;
+                break;
+            }
+            out << std::setw(14) << formatCount(count) << " (" << std::fixed << std::setprecision(3) << seconds << "s)";
+            if (static_cast<uint128>(count) == expected) {
+                out << " [PASS]\n";
+            } else {
+                out << " [FAIL] Expected " << formatCount(expected) << "\n";
+                result.passed = false;
+            }
+        }
+        result.text = out.str();
+    };
+
+    const auto start = SearchMonitor::Clock::now();
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i = next++; i < positions.size(); i = next++) {
+            runPosition(positions[i], results[i]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < std::min<int>(jobs, static_cast<int>(positions.size())); ++t) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(SearchMonitor::Clock::now() - start).count();
+
+    size_t passed = 0;
+    for (const Result& result : results) {
+        std::cout << result.text;
+        passed += result.passed;
+    }
+    std::cout << "\n" << passed << "/" << positions.size() << " positions passed in " << std::fixed
+              << std::setprecision(3) << seconds << "s (" << jobs << " jobs)\n";
+    return passed == positions.size() ? 0 : 1;
+}
+
+template <typename Count>
+int runPerft(const Board& initialBoard, const PerftOptions& options) {
+    const int max_depth_limit = options.maxDepth;
+    const std::string& modeStr = options.modeStr;
 
     // Pre-fetch all pieces
     const auto& pieces = getAllPieces();
@@ -149,45 +1044,310 @@ int main(int argc, char* argv[]) {
         {"nearfull:2", 4380},
         {"nearfull:3", 507036},
         {"nearfull:4", 142586120},
+        {"nearfull:5", 42625048272},
     };
 
-    TranspositionTable tt;
+    TranspositionTable<Count> tt;
+    tt.file = options.ttFile;
+
+    // Hardware counters around each depth, reported per terminal node
+    PerfCounters counters;
+    if (options.perfCounters && !counters.open(PerfCounters::ALL_EVENTS)) {
+        std::cout << "Perf counters unavailable (" << counters.error() << ")\n\n";
+    }
 
     auto total_start = std::chrono::high_resolution_clock::now();
 
+    SearchMonitor monitor;
+    monitor.tt = &tt;
+    monitor.progressInterval = options.progressInterval;
+    if (options.timeLimit > 0) {
+        monitor.deadline = SearchMonitor::Clock::now() +
+                           std::chrono::duration_cast<SearchMonitor::Clock::duration>(std::chrono::duration<double>(options.timeLimit));
+    }
+    std::vector<RootCount<Count>> finishedRoots;
+    std::vector<PieceType> hand = options.hand;
+
     // We run for the specific max_depth requested.
     // The user prompt implied: "for each depth from 0 up to max_depth".
     // This usually means running the full perft for d=0, then d=1, ... d=max_depth.
     
     bool all_passed = true;
 
-    for (int d = 0; d <= max_depth_limit; ++d) {
-        auto depth_start = std::chrono::high_resolution_clock::now();
-        
-        uint64_t count = countTerminalNodes(initialBoard, 0, d, pieces, tt);
-        
-        auto depth_end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> diff = depth_end - depth_start;
-        
+    // Depth line with the baseline check; false on a mismatch
+    auto reportDepth = [&](int d, Count count, double seconds) {
         std::string key = modeStr + ":" + std::to_string(d);
-        
-        std::cout << "Depth " << d << ": " << std::setw(12) << count 
-                  << " nodes (" << std::fixed << std::setprecision(3) << diff.count() << "s)";
 
+        std::cout << "Depth " << d << ": " << std::setw(12) << formatCount(count)
+                  << " nodes (" << std::fixed << std::setprecision(3) << seconds << "s)";
+
+        bool passed = true;
         if (BASELINE.count(key)) {
             uint64_t expected = BASELINE.at(key);
             if (count == expected) {
                 std::cout << " [PASS]";
             } else {
                 std::cout << " [FAIL] Expected " << expected;
-                all_passed = false;
+                passed = false;
             }
         } else {
             std::cout << " [NEW]";
         }
         std::cout << "\n";
-        tt.clear();
+        return passed;
+    };
+
+    auto reportOverflow = [&](int d) {
+        std::cout << "Depth " << d << ": count overflows " << countBits<Count>() << " bits";
+        if (countBits<Count>() < 128) {
+            std::cout << ", rerun with --count 128";
+        }
+        std::cout << "\n";
+    };
+
+    if (!options.distributed.dir.empty()) {
+        Count count = 0;
+        bool overflowed = false;
+        if (!runCoordinator(initialBoard, max_depth_limit, options.distributed, tt.file, options.progressInterval,
+                            count, overflowed)) {
+            return 1;
+        }
+        if (overflowed) {
+            reportOverflow(max_depth_limit);
+            return 1;
+        }
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - total_start;
+        return reportDepth(max_depth_limit, count, diff.count()) ? 0 : 1;
+    }
+
+    for (int d = 0; d <= max_depth_limit; ++d) {
+        auto depth_start = std::chrono::high_resolution_clock::now();
+        
+        monitor.beginDepth(d);
+        counters.start();
+        Count count = hand.empty() ? countByRootMove(initialBoard, d, pieces, tt, monitor, finishedRoots)
+                                   : countHandNodes<Count>(initialBoard, hand, 0, d, monitor);
+        counters.stop();
+        
+        auto depth_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> diff = depth_end - depth_start;
+
+        if (monitor.overflowed) {
+            reportOverflow(d);
+            return 1;
+        }
+        if (monitor.stopped) {
+            std::cout << "Depth " << d << ": stopped by time limit after " << std::fixed << std::setprecision(3)
+                      << diff.count() << "s, " << monitor.rootsDone << "/" << monitor.rootsTotal
+                      << " root moves finished with " << formatCount(count) << " nodes\n";
+            for (const RootCount<Count>& root : finishedRoots) {
+                std::cout << "  " << getPiece(root.type).name << " @ " << root.row << "," << root.col << ": "
+                          << formatCount(root.count) << "\n";
+            }
+            break;
+        }
+
+        all_passed = reportDepth(d, count, diff.count()) && all_passed;
+        if (counters.available()) {
+            std::cout << "  " << counters.read().describe(static_cast<double>(count), "node") << "\n";
+        }
+        tt.resetStats();
     }
     
     return all_passed ? 0 : 1;
 }
+
+int main(int argc, char* argv[]) {
+    PerftOptions options;
+    Mode mode = Mode::DEFAULT;
+    int countWidth = 64;
+    std::string ttFilePath;
+    int ttFileBits = PerftCache::DEFAULT_BITS;
+    bool splitGiven = false;
+    bool leaseGiven = false;
+    std::string workerDir;
+    std::optional<uint64_t> boardData;
+    std::string batchPath;
+    int jobs = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    DistributedOptions& distributed = options.distributed;
+
+    // Positional: [max depth] [mode]; options may appear anywhere
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--perf-counters") {
+            options.perfCounters = true;
+        } else if (arg == "--progress" || arg == "--time-limit" || arg == "--tt-file" || arg == "--tt-file-bits" ||
+                   arg == "--distribute" || arg == "--split" || arg == "--tasks" || arg == "--workers" ||
+                   arg == "--lease" || arg == "--worker" || arg == "--count" || arg == "--board" || arg == "--hand" ||
+                   arg == "--batch" || arg == "--jobs") {
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            const std::string value = argv[++i];
+            try {
+                if (arg == "--progress") {
+                    options.progressInterval = std::stod(value);
+                } else if (arg == "--time-limit") {
+                    options.timeLimit = std::stod(value);
+                } else if (arg == "--tt-file") {
+                    ttFilePath = value;
+                } else if (arg == "--tt-file-bits") {
+                    ttFileBits = std::stoi(value);
+                    if (ttFileBits < PerftCache::MIN_BITS || ttFileBits > PerftCache::MAX_BITS) {
+                        throw std::invalid_argument(value);
+                    }
+                } else if (arg == "--distribute") {
+                    distributed.dir = value;
+                } else if (arg == "--split") {
+                    distributed.split = std::stoi(value);
+                    splitGiven = true;
+                } else if (arg == "--tasks") {
+                    distributed.tasks = std::max(1, std::stoi(value));
+                } else if (arg == "--workers") {
+                    distributed.workers = std::max(0, std::stoi(value));
+                } else if (arg == "--lease") {
+                    distributed.lease = std::stod(value);
+                    if (!(distributed.lease > 0)) {
+                        throw std::invalid_argument(value);
+                    }
+                    leaseGiven = true;
+                } else if (arg == "--board") {
+                    boardData = std::stoull(value, nullptr, 16);
+                } else if (arg == "--hand") {
+                    if (!parseHand(value, options.hand)) {
+                        throw std::invalid_argument(value);
+                    }
+                } else if (arg == "--batch") {
+                    batchPath = value;
+                } else if (arg == "--jobs") {
+                    jobs = std::max(1, std::stoi(value));
+                } else if (arg == "--count") {
+                    countWidth = std::stoi(value);
+                    if (countWidth != 64 && countWidth != 128) {
+                        throw std::invalid_argument(value);
+                    }
+                } else {
+                    workerDir = value;
+                }
+            } catch (...) {
+                std::cerr << "Invalid value for " << arg << "\n";
+                return 1;
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (!workerDir.empty()) {
+        PerftCache workerFile;
+        if (!ttFilePath.empty() && !workerFile.open(ttFilePath, ttFileBits)) {
+            std::cerr << "Error: " << workerFile.error() << "\n";
+            return 1;
+        }
+        return runWorker(workerDir, workerFile.isOpen() ? &workerFile : nullptr,
+                         leaseGiven ? std::optional<double>(distributed.lease) : std::nullopt);
+    }
+
+    if (positional.size() > 0) {
+        try {
+            options.maxDepth = std::stoi(positional[0]);
+        } catch (...) {
+            std::cerr << "Invalid argument for max depth\n";
+            return 1;
+        }
+    }
+    
+    if (positional.size() > 1) {
+        options.modeStr = positional[1];
+        if (options.modeStr == "nearfull") {
+            mode = Mode::NEARFULL;
+        } else if (options.modeStr != "default") {
+            std::cerr << "Unknown mode: " << options.modeStr << ". Using default.\n";
+            options.modeStr = "default";
+        }
+    }
+
+    if (boardData || !options.hand.empty()) {
+        options.modeStr = "custom";     // No baseline
+    }
+
+    if (!batchPath.empty()) {
+        std::vector<Position> positions;
+        if (!readBatch(batchPath, positions)) {
+            return 1;
+        }
+        PerftCache batchFile;
+        if (!ttFilePath.empty()) {
+            if (!batchFile.open(ttFilePath, ttFileBits)) {
+                std::cerr << "Error: " << batchFile.error() << "\n";
+                return 1;
+            }
+            options.ttFile = &batchFile;
+        }
+        std::cout << "Running Perft batch " << batchPath << ": " << positions.size() << " positions\n\n";
+        return countWidth == 128 ? runBatch<uint128>(positions, options, jobs)
+                                 : runBatch<uint64_t>(positions, options, jobs);
+    }
+
+    if (!distributed.dir.empty()) {
+        if (!options.hand.empty()) {
+            std::cerr << "Error: --hand cannot be distributed\n";
+            return 1;
+        }
+        if (!splitGiven) {
+            distributed.split = std::min(distributed.split, options.maxDepth - 1);
+        }
+        // Every task counts at least one ply, otherwise the workers only confirm leaves
+        if (distributed.split < 0 || distributed.split > options.maxDepth - 1) {
+            std::cerr << "Error: --split must be between 0 and the max depth - 1\n";
+            return 1;
+        }
+    }
+    
+    std::cout << "Running Perft (Terminal Node Count)\n";
+    std::cout << "  Max Depth: " << options.maxDepth << "\n";
+    std::cout << "  Mode:      " << options.modeStr << "\n";
+    if (boardData) {
+        std::cout << "  Board:     " << formatBoard(Board(*boardData)) << "\n";
+    }
+    if (!options.hand.empty()) {
+        std::cout << "  Hand:      " << formatHand(options.hand) << "\n";
+    }
+    std::cout << "  Counts:    " << countWidth << "-bit\n\n";
+    
+    // Initialize board based on mode
+    Board initialBoard;
+    if (boardData) {
+        initialBoard = Board(*boardData);
+    } else if (mode == Mode::NEARFULL) {
+        // Fill all but top/bottom row and left/right col
+        // Rows 1-6, Cols 1-6
+        for (int r = 1; r <= 6; ++r) {
+            for (int c = 1; c <= 6; ++c) {
+                initialBoard.setOccupied(r, c);
+            }
+        }
+    }
+
+    PerftCache ttFile;
+    if (!ttFilePath.empty()) {
+        if (!ttFile.open(ttFilePath, ttFileBits)) {
+            std::cerr << "Error: " << ttFile.error() << "\n";
+            return 1;
+        }
+        options.ttFile = &ttFile;
+        std::cout << "TT file " << ttFilePath << ": " << ttFile.capacity() << " entries, " << ttFile.used()
+                  << " in use\n\n";
+    }
+
+    return countWidth == 128 ? runPerft<uint128>(initialBoard, options) : runPerft<uint64_t>(initialBoard, options);
+}
@@ -0,0 +1,201 @@
+#include "perft_cache.hpp"
+#include "pieces.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BlockGame {
+
+namespace {
+
+constexpr char MAGIC[4] = {'B', 'G', 'P', 'C'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t HEADER_BYTES = 64;
+constexpr int WORDS_PER_ENTRY = 2;
+constexpr uint64_t COUNT_MASK = PerftCache::MAX_COUNT;
+
+// Changes whenever a piece is added, removed or reshaped
+uint64_t pieceFingerprint() {
+    uint64_t h = NUM_PIECES;
+    for (const auto& piece : getAllPieces()) {
+        h = (h ^ piece.baseMask) * 0x100000001b3ULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+inline uint64_t load(const uint64_t& word) {
+    return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(word)).load(std::memory_order_relaxed);
+}
+
+inline void save(uint64_t& word, uint64_t value) {
+    std::atomic_ref<uint64_t>(word).store(value, std::memory_order_relaxed);
+}
+
+// Start of the 64 byte header, the rest is zero
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t bits;
+    uint32_t reserved;
+    uint64_t fingerprint;
+};
+
+} // anonymous namespace
+
+PerftCache::~PerftCache() {
+    close();
+}
+
+bool PerftCache::open(const std::string& path, int bits) {
+    close();
+    // Know whether the file is ours, so a failed initialisation does not leave it behind
+    bool created = true;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = ::open(path.c_str(), O_RDWR);
+    }
+    if (fd < 0) {
+        error_ = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // Exclusive while creating or checking the header, so two processes starting
+    // together cannot both initialise the file
+    flock(fd, LOCK_EX);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        error_ = path + ": " + std::strerror(errno);
+        if (created) unlink(path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    Header header;
+    if (st.st_size == 0) {
+        if (bits < MIN_BITS || bits > MAX_BITS) {
+            error_ = path + ": table bits must be between " + std::to_string(MIN_BITS) + " and " +
+                     std::to_string(MAX_BITS);
+            if (created) unlink(path.c_str());
+            ::close(fd);
+            return false;
+        }
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, MAGIC, 4);
+        header.version = VERSION;
+        header.bits = static_cast<uint32_t>(bits);
+        header.fingerprint = pieceFingerprint();
+        const size_t bytes = HEADER_BYTES + (size_t{1} << bits) * WORDS_PER_ENTRY * sizeof(uint64_t);
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0 ||
+            pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+            error_ = path + ": cannot create cache file";
+            if (created) unlink(path.c_str());
+            ::close(fd);
+            return false;
+        }
+        st.st_size = static_cast<off_t>(bytes);
+    } else if (static_cast<size_t>(st.st_size) < HEADER_BYTES ||
+               pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        error_ = path + ": not a perft cache file";
+        ::close(fd);
+        return false;
+    }
+    flock(fd, LOCK_UN);
+
+    if (std::memcmp(header.magic, MAGIC, 4) != 0 || header.version != VERSION || header.bits < MIN_BITS || header.bits > MAX_BITS ||
+        static_cast<size_t>(st.st_size) != HEADER_BYTES + (size_t{1} << header.bits) * WORDS_PER_ENTRY * sizeof(uint64_t)) {
+        error_ = path + ": not a perft cache file";
+        ::close(fd);
+        return false;
+    }
+    if (header.fingerprint != pieceFingerprint()) {
+        error_ = path + ": written for a different piece set";
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error_ = path + ": " + std::strerror(errno);
+        return false;
+    }
+    mapping_ = mapping;
+    mappedBytes_ = static_cast<size_t>(st.st_size);
+    entries_ = reinterpret_cast<uint64_t*>(static_cast<uint8_t*>(mapping) + HEADER_BYTES);
+    mask_ = (size_t{1} << header.bits) - 1;
+    error_.clear();
+    return true;
+}
+
+void PerftCache::close() {
+    if (mapping_) munmap(mapping_, mappedBytes_);
+    mapping_ = nullptr;
+    mappedBytes_ = 0;
+    entries_ = nullptr;
+    mask_ = 0;
+}
+
+size_t PerftCache::bucket(uint64_t board, int remaining) const {
+    // Full avalanche: boards often differ only in their top rows, i.e. the high bits
+    uint64_t h = board ^ static_cast<uint64_t>(remaining) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h) & mask_ & ~size_t{1};
+}
+
+bool PerftCache::probe(uint64_t board, int remaining, uint64_t& count) const {
+    const size_t first = bucket(board, remaining);
+    for (size_t i = first; i < first + 2; ++i) {
+        const uint64_t* entry = entries_ + i * WORDS_PER_ENTRY;
+        const uint64_t data = load(entry[1]);
+        if (data && (load(entry[0]) ^ data) == board && static_cast<int>(data >> 56) == remaining) {
+            count = data & COUNT_MASK;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerftCache::store(uint64_t board, int remaining, uint64_t count) {
+    if (count == 0 || count > MAX_COUNT || remaining < 0 || remaining > 255) return;
+    const uint64_t data = count | static_cast<uint64_t>(remaining) << 56;
+
+    // The entry already holding the key, else the first if at least as deep as what it holds, else the second
+    const size_t first = bucket(board, remaining);
+    size_t target = first + 1;
+    for (size_t i = first; i < first + 2; ++i) {
+        const uint64_t* entry = entries_ + i * WORDS_PER_ENTRY;
+        const uint64_t old = load(entry[1]);
+        if (old && (load(entry[0]) ^ old) == board && static_cast<int>(old >> 56) == remaining) {
+            target = i;
+            break;
+        }
+        if (i == first && (!old || remaining >= static_cast<int>(old >> 56))) {
+            target = i;
+        }
+    }
+    uint64_t* entry = entries_ + target * WORDS_PER_ENTRY;
+    save(entry[0], board ^ data);
+    save(entry[1], data);
+}
+
+size_t PerftCache::used() const {
+    size_t n = 0;
+    for (size_t i = 0; i <= mask_ && entries_; ++i) {
+        n += load(entries_[i * WORDS_PER_ENTRY + 1]) != 0;
+    }
+    return n;
+}
+
+} // namespace BlockGame
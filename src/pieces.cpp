@@ -1,4 +1,5 @@
 #include "pieces.hpp"
+#include "board.hpp"
 #include <sstream>
 
 namespace BlockGame {
@@ -68,11 +69,16 @@ PieceShiftTable buildShiftTable(uint64_t baseMask, int width, int height) {
     PieceShiftTable table;
     table.maxRow = 8 - height;
     table.maxCol = 8 - width;
+    table.originMask = 0;
     
     for (int pos = 0; pos < 64; ++pos) {
         int row = pos / 8;
         int col = pos % 8;
         table.masks[pos] = computeShiftedMask(baseMask, width, height, row, col);
+        table.lines[pos] = Board::linesTouched(table.masks[pos]);
+        if (table.masks[pos] != 0) {
+            table.originMask |= 1ULL << pos;
+        }
     }
     return table;
 }
@@ -0,0 +1,142 @@
+#include "planner.hpp"
+#include "pieces.hpp"
+#include "trace.hpp"
+#include <algorithm>
+
+namespace BlockGame {
+
+namespace {
+
+// Sort by key, best points first, then keep the first node per key
+void dedupLayer(std::vector<HandPlanner::Node>& layer) {
+    std::sort(layer.begin(), layer.end(), [](const HandPlanner::Node& a, const HandPlanner::Node& b) {
+        if (a.board != b.board) return a.board < b.board;
+        if (a.used != b.used) return a.used < b.used;
+        return a.points > b.points;
+    });
+    auto last = std::unique(layer.begin(), layer.end(), [](const HandPlanner::Node& a, const HandPlanner::Node& b) {
+        return a.board == b.board && a.used == b.used;
+    });
+    layer.erase(last, layer.end());
+}
+
+// Depth-first search for any order that places every piece.
+// Each piece's clearing placements go first when clearingFirst is set.
+bool placeAll(uint64_t board, PieceType* pieces, int count, bool clearingFirst, CutoffHistogram& cutoffs) {
+    if (count == 0) return true;
+    int tried = 0;
+    for (int i = 0; i < count; ++i) {
+        if (std::find(pieces, pieces + i, pieces[i]) != pieces + i) continue;
+        const Piece& piece = getPiece(pieces[i]);
+        const uint64_t fits = Board(board).fitMask(piece);
+        const uint64_t clearing = clearingFirst ? Board(board).clearingFits(piece, fits) : 0;
+        std::swap(pieces[i], pieces[count - 1]);
+        bool found = false;
+        for (uint64_t group : {clearing, fits & ~clearing}) {
+            for (; group && !found; group &= group - 1) {
+                const int pos = __builtin_ctzll(group);
+                Board child(board);
+                const int lines = child.placeAndClear(piece.shiftToUnsafe(pos / 8, pos % 8));
+                found = placeAll(child.data(), pieces, count - 1, clearingFirst, cutoffs);
+                if (found) cutoffs.cutoff(tried, lines > 0);
+                tried++;
+            }
+        }
+        std::swap(pieces[i], pieces[count - 1]);
+        if (found) return true;
+    }
+    cutoffs.exhausted();
+    return false;
+}
+
+} // anonymous namespace
+
+bool HandPlanner::feasible(const Board& board, const PieceType* pieces, int count) {
+    HandCache::Key key{};
+    bool result = false;
+    if (cache_) {
+        key = HandCache::makeKey(board.data(), pieces, count);
+        if (cache_->probe(key, result)) return result;
+    }
+
+    PieceType scratch[Game::HAND_SIZE];
+    std::copy(pieces, pieces + count, scratch);
+    result = placeAll(board.data(), scratch, count, clearingFirst_, cutoffs_);
+    if (cache_) cache_->store(key, result);
+    return result;
+}
+
+int HandPlanner::expand(const Board& board, const PieceType* pieces, int count) {
+    BG_TRACE_SCOPE("HandPlanner::expand");
+    count_ = count;
+    depth_ = 0;
+    for (auto& layer : layers_) {
+        layer.clear();
+    }
+    layers_[0].push_back({board.data(), 0, -1, 0, 0, 0});
+
+    for (int level = 0; level < count; ++level) {
+        const auto& current = layers_[level];
+        auto& next = layers_[level + 1];
+
+        for (size_t i = 0; i < current.size(); ++i) {
+            const Node& node = current[i];
+            const Board nodeBoard(node.board);
+            uint8_t triedTypes[Game::HAND_SIZE];
+            int numTried = 0;
+
+            for (int slot = 0; slot < count; ++slot) {
+                if (node.used & (1u << slot)) continue;
+
+                // Identical pieces in different slots produce identical children
+                const uint8_t type = static_cast<uint8_t>(pieces[slot]);
+                if (std::find(triedTypes, triedTypes + numTried, type) != triedTypes + numTried) continue;
+                triedTypes[numTried++] = type;
+
+                const Piece& piece = getPiece(pieces[slot]);
+                for (uint64_t fits = nodeBoard.fitMask(piece); fits; fits &= fits - 1) {
+                    const int pos = __builtin_ctzll(fits);
+                    Board child = nodeBoard;
+                    const int lines = child.placeAndClear(piece.shiftToUnsafe(pos / 8, pos % 8));
+                    next.push_back({child.data(),
+                                    node.points + Game::calculateClearScore(lines),
+                                    static_cast<int32_t>(i),
+                                    static_cast<uint8_t>(node.used | (1u << slot)),
+                                    type,
+                                    static_cast<uint8_t>(pos)});
+                }
+            }
+        }
+
+        if (next.empty()) break;
+        dedupLayer(next);
+        depth_ = level + 1;
+    }
+
+    if (cache_ && count > 0) {
+        cache_->store(HandCache::makeKey(board.data(), pieces, count), complete());
+    }
+
+    return depth_;
+}
+
+HandPlan HandPlanner::plan(size_t index) const {
+    HandPlan result;
+    const Node& leaf = layers_[depth_][index];
+    result.board = Board(leaf.board);
+    result.points = leaf.points;
+    result.numMoves = depth_;
+
+    int32_t cursor = static_cast<int32_t>(index);
+    for (int level = depth_; level > 0; --level) {
+        const Node& node = layers_[level][cursor];
+        const PieceType type = static_cast<PieceType>(node.type);
+        const int row = node.pos / 8;
+        const int col = node.pos % 8;
+        result.moves[level - 1] = {type, row, col, getPiece(type).shiftToUnsafe(row, col)};
+        cursor = node.parent;
+    }
+    return result;
+}
+
+} // namespace BlockGame
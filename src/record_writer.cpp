@@ -0,0 +1,102 @@
+#include "record_writer.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace BlockGame {
+
+namespace {
+
+// Longest formatted record is well below this
+constexpr size_t MAX_RECORD_SIZE = 256;
+
+} // anonymous namespace
+
+RecordWriter::~RecordWriter() {
+    close();
+}
+
+bool RecordWriter::open(const std::string& path, Format format, size_t bufferSize) {
+    close();
+    if (path == "-") {
+        file_ = stdout;
+        ownsFile_ = false;
+    } else {
+        file_ = std::fopen(path.c_str(), "w");
+        ownsFile_ = true;
+    }
+    if (!file_) return false;
+
+    format_ = format;
+    failed_ = false;
+    buffer_.resize(std::max(bufferSize, 2 * MAX_RECORD_SIZE));
+    used_ = 0;
+
+    if (format_ == Format::CSV) {
+        append("seed,score,turns,moves,wall_seconds\n");
+    }
+    return true;
+}
+
+void RecordWriter::write(const GameRecord& record) {
+    if (!file_) return;
+    if (used_ + MAX_RECORD_SIZE > buffer_.size()) {
+        flush();
+    }
+
+    if (format_ == Format::CSV) {
+        appendNumber(record.seed);
+        append(",");
+        appendNumber(record.score);
+        append(",");
+        appendNumber(record.turns);
+        append(",");
+        appendNumber(record.moves);
+        append(",");
+        appendNumber(record.wallSeconds);
+        append("\n");
+    } else {
+        append("{\"seed\":");
+        appendNumber(record.seed);
+        append(",\"score\":");
+        appendNumber(record.score);
+        append(",\"turns\":");
+        appendNumber(record.turns);
+        append(",\"moves\":");
+        appendNumber(record.moves);
+        append(",\"wall_seconds\":");
+        appendNumber(record.wallSeconds);
+        append("}\n");
+    }
+}
+
+bool RecordWriter::close() {
+    if (!file_) return !failed_;
+    flush();
+    if (std::fflush(file_) != 0) failed_ = true;
+    if (ownsFile_ && std::fclose(file_) != 0) failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+}
+
+void RecordWriter::flush() {
+    if (used_ == 0) return;
+    if (std::fwrite(buffer_.data(), 1, used_, file_) != used_) {
+        failed_ = true;
+    }
+    used_ = 0;
+}
+
+void RecordWriter::append(const char* text) {
+    const size_t len = std::strlen(text);
+    std::memcpy(buffer_.data() + used_, text, len);
+    used_ += len;
+}
+
+template <typename T>
+void RecordWriter::appendNumber(T value) {
+    auto result = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value);
+    used_ = static_cast<size_t>(result.ptr - buffer_.data());
+}
+
+} // namespace BlockGame
@@ -0,0 +1,244 @@
+#include "replay.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BlockGame {
+
+namespace {
+
+// Flush the output buffer once it grows past this
+constexpr size_t OUTPUT_FLUSH_BYTES = 1 << 20;
+
+template <typename T>
+void appendValue(std::vector<uint8_t>& out, T value) {
+    const size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <typename T>
+void storeValue(std::vector<uint8_t>& out, size_t at, T value) {
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <typename T>
+T loadValue(const uint8_t* at) {
+    T value;
+    std::memcpy(&value, at, sizeof(T));
+    return value;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+ReplayWriter::~ReplayWriter() {
+    close();
+}
+
+bool ReplayWriter::open(const std::string& path, uint8_t strategyId, uint16_t snapshotInterval) {
+    close();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+
+    failed_ = false;
+    strategyId_ = strategyId;
+    snapshotInterval_ = snapshotInterval;
+    output_.assign(sizeof(Replay::MAGIC), 0);
+    std::memcpy(output_.data(), Replay::MAGIC, sizeof(Replay::MAGIC));
+    appendValue(output_, Replay::VERSION);
+    appendValue(output_, snapshotInterval_);
+    appendValue(output_, uint64_t{0});
+    return true;
+}
+
+bool ReplayWriter::close() {
+    if (!file_) return !failed_;
+    flush();
+    if (std::fclose(file_) != 0) failed_ = true;
+    file_ = nullptr;
+    return !failed_;
+}
+
+void ReplayWriter::flush() {
+    if (output_.empty()) return;
+    if (std::fwrite(output_.data(), 1, output_.size(), file_) != output_.size()) {
+        failed_ = true;
+    }
+    output_.clear();
+}
+
+void ReplayWriter::beginGame(uint64_t seed, const Game& game) {
+    seed_ = seed;
+    numTurns_ = 0;
+    numMoves_ = 0;
+    game_.assign(Replay::GAME_HEADER_BYTES, 0);
+    // The constructor's hand is not reported through onHandDrawn
+    startTurn(game);
+}
+
+void ReplayWriter::startTurn(const Game& game) {
+    uint32_t word = 0;
+    for (int i = 0; i < Game::HAND_SIZE; ++i) {
+        word |= static_cast<uint32_t>(game.hand()[i]) << (6 * i);
+    }
+    const bool snapshot = snapshotInterval_ != 0 && numTurns_ % snapshotInterval_ == 0;
+    if (snapshot) word |= Replay::SNAPSHOT_BIT;
+
+    turnOffset_ = game_.size();
+    appendValue(game_, word);
+    if (snapshot) appendValue(game_, game.board().data());
+    numTurns_++;
+}
+
+void ReplayWriter::onHandDrawn(const Game& game) {
+    startTurn(game);
+}
+
+void ReplayWriter::onPlacement(const Game&, int handIndex, int row, int col, int) {
+    uint32_t word = loadValue<uint32_t>(game_.data() + turnOffset_);
+    word += 1u << 18;
+    storeValue(game_, turnOffset_, word);
+    game_.push_back(static_cast<uint8_t>((row * 8 + col) | (handIndex << 6)));
+    numMoves_++;
+}
+
+void ReplayWriter::endGame(const Game& game) {
+    if (!file_) return;
+    storeValue(game_, 0, static_cast<uint32_t>(game_.size()));
+    storeValue(game_, 4, seed_);
+    storeValue(game_, 12, static_cast<int32_t>(game.score()));
+    storeValue(game_, 16, numTurns_);
+    storeValue(game_, 20, numMoves_);
+    game_[24] = strategyId_;
+
+    output_.insert(output_.end(), game_.begin(), game_.end());
+    if (output_.size() >= OUTPUT_FLUSH_BYTES) {
+        flush();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+uint64_t ReplayGame::seed() const { return loadValue<uint64_t>(data_ + 4); }
+int ReplayGame::finalScore() const { return loadValue<int32_t>(data_ + 12); }
+uint32_t ReplayGame::numTurns() const { return loadValue<uint32_t>(data_ + 16); }
+uint32_t ReplayGame::numMoves() const { return loadValue<uint32_t>(data_ + 20); }
+uint8_t ReplayGame::strategyId() const { return data_[24]; }
+
+bool ReplayGame::TurnCursor::next(ReplayTurn& turn) {
+    if (end_ - pos_ < 4) return false;
+    const uint32_t word = loadValue<uint32_t>(pos_);
+    pos_ += 4;
+
+    for (int i = 0; i < Game::HAND_SIZE; ++i) {
+        const uint32_t type = (word >> (6 * i)) & 0x3F;
+        if (type >= static_cast<uint32_t>(NUM_PIECES)) return false;
+        turn.hand[i] = static_cast<PieceType>(type);
+    }
+    turn.numPlacements = (word >> 18) & 0x3;
+    turn.hasSnapshot = (word & Replay::SNAPSHOT_BIT) != 0;
+    turn.snapshot = 0;
+
+    if (turn.hasSnapshot) {
+        if (end_ - pos_ < 8) return false;
+        turn.snapshot = loadValue<uint64_t>(pos_);
+        pos_ += 8;
+    }
+    if (end_ - pos_ < turn.numPlacements) return false;
+    for (int i = 0; i < turn.numPlacements; ++i) {
+        turn.positions[i] = pos_[i] & 0x3F;
+        turn.slots[i] = pos_[i] >> 6;
+    }
+    pos_ += turn.numPlacements;
+    return true;
+}
+
+ReplayReader::~ReplayReader() {
+    close();
+}
+
+bool ReplayReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < Replay::FILE_HEADER_BYTES) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    data_ = static_cast<const uint8_t*>(mapping);
+    size_ = static_cast<size_t>(st.st_size);
+    if (std::memcmp(data_, Replay::MAGIC, 4) != 0 || loadValue<uint16_t>(data_ + 4) != Replay::VERSION) {
+        close();
+        return false;
+    }
+    snapshotInterval_ = loadValue<uint16_t>(data_ + 6);
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+    rewind();
+    return true;
+}
+
+void ReplayReader::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    offset_ = 0;
+}
+
+bool ReplayReader::next(ReplayGame& game) {
+    if (!data_ || size_ - offset_ < Replay::GAME_HEADER_BYTES) return false;
+    const uint32_t blockBytes = loadValue<uint32_t>(data_ + offset_);
+    if (blockBytes < Replay::GAME_HEADER_BYTES || blockBytes > size_ - offset_) return false;
+
+    game = ReplayGame(data_ + offset_, blockBytes);
+    offset_ += blockBytes;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Replay
+// ---------------------------------------------------------------------------
+
+bool replayGame(const ReplayGame& recorded, int* replayedScore) {
+    Game game(recorded.seed());
+    bool matches = true;
+    uint32_t turns = 0;
+
+    ReplayTurn turn{};
+    auto cursor = recorded.turns();
+    while (matches && cursor.next(turn)) {
+        turns++;
+        if (game.hand() != turn.hand) matches = false;
+        if (turn.hasSnapshot && game.board().data() != turn.snapshot) matches = false;
+
+        for (int i = 0; matches && i < turn.numPlacements; ++i) {
+            const int row = turn.positions[i] / 8;
+            const int col = turn.positions[i] % 8;
+            if (!game.canPlace(turn.slots[i], row, col)) {
+                matches = false;
+                break;
+            }
+            game.placePiece(turn.slots[i], row, col);
+        }
+    }
+
+    if (replayedScore) *replayedScore = game.score();
+    return matches && turns == recorded.numTurns() && game.isGameOver() && game.score() == recorded.finalScore();
+}
+
+} // namespace BlockGame
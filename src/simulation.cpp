@@ -0,0 +1,101 @@
+#include "simulation.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iterator>
+#include <iostream>
+#include <random>
+
+namespace BlockGame {
+
+std::unique_ptr<Strategy> makeStrategy(const std::string& name, uint64_t seed, const BeamConfig& beamConfig,
+                                       std::shared_ptr<const Evaluator> evaluator) {
+    if (!evaluator) {
+        evaluator = std::make_shared<HeuristicEvaluator>();
+    }
+    if (name == "random") {
+        return std::make_unique<RandomStrategy>(seed);
+    } else if (name == "greedy") {
+        return std::make_unique<GreedyStrategy>(evaluator);
+    } else if (name == "beam") {
+        return std::make_unique<BeamStrategy>(evaluator, beamConfig, seed);
+    }
+    return nullptr;
+}
+
+int strategyId(const std::string& name) {
+    // Append only: ids are stored in replay files
+    static const char* const NAMES[] = {"random", "greedy", "beam"};
+    for (int i = 0; i < static_cast<int>(std::size(NAMES)); ++i) {
+        if (name == NAMES[i]) return i;
+    }
+    return -1;
+}
+
+std::vector<uint64_t> makeGameSeeds(uint64_t seed, int count) {
+    std::vector<uint64_t> seeds(count);
+    std::mt19937_64 seedRng(seed);
+    for (auto& s : seeds) {
+        s = seedRng();
+    }
+    return seeds;
+}
+
+namespace {
+
+// Shared game loop: plays numRuns games with seeds from seedAt(i) and hands each record to onGame,
+// which returns true to stop early
+template <typename SeedFn, typename GameFn>
+void playGames(Strategy& strategy, uint64_t numRuns, SeedFn seedAt, bool showProgress, GameFn onGame,
+               GameRecorder* recorder) {
+    for (uint64_t i = 0; i < numRuns; ++i) {
+        const uint64_t gameSeed = seedAt(i);
+        auto startTime = std::chrono::steady_clock::now();
+        Game game(gameSeed);
+        if (recorder) {
+            recorder->beginGame(gameSeed, game);
+            game.setObserver(recorder);
+        }
+        const int score = strategy.playGame(game);
+        if (recorder) recorder->endGame(game);
+        auto endTime = std::chrono::steady_clock::now();
+        const GameRecord record{gameSeed, score, game.turnNumber(), game.movesMade(),
+                                std::chrono::duration<double>(endTime - startTime).count()};
+
+        // Progress indicator
+        if (showProgress && numRuns >= 10 && ((i + 1) % (numRuns / 10) == 0 || i == numRuns - 1)) {
+            uint64_t pct = (i + 1) * 100 / numRuns;
+            std::cout << "\r  Progress: " << std::setw(3) << pct << "% (" << (i + 1) << "/" << numRuns << ")" << std::flush;
+        }
+
+        if (onGame(record)) break;
+    }
+}
+
+} // anonymous namespace
+
+std::vector<int> runSimulations(Strategy& strategy, const std::vector<uint64_t>& gameSeeds, bool showProgress,
+                                const GameCallback& onGame, GameRecorder* recorder) {
+    std::vector<int> scores;
+    scores.reserve(gameSeeds.size());
+
+    playGames(strategy, gameSeeds.size(), [&](uint64_t i) { return gameSeeds[i]; }, showProgress, [&](const GameRecord& record) {
+        scores.push_back(record.score);
+        return onGame && onGame(record);
+    }, recorder);
+    return scores;
+}
+
+ScoreHistogram streamSimulations(Strategy& strategy, uint64_t seed, uint64_t numRuns, bool showProgress,
+                                 const GameCallback& onGame, GameRecorder* recorder) {
+    ScoreHistogram histogram;
+    // Same seed sequence as makeGameSeeds, generated on the fly
+    std::mt19937_64 seedRng(seed);
+
+    playGames(strategy, numRuns, [&](uint64_t) { return seedRng(); }, showProgress, [&](const GameRecord& record) {
+        histogram.add(record.score);
+        return onGame && onGame(record);
+    }, recorder);
+    return histogram;
+}
+
+} // namespace BlockGame
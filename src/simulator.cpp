@@ -1,4 +1,16 @@
+#include "dataset.hpp"
+#include "endgame.hpp"
 #include "game.hpp"
+#include "nn_evaluator.hpp"
+#include "ntuple.hpp"
+#include "perf_counters.hpp"
+#include "record_writer.hpp"
+#include "replay.hpp"
+#include "simulation.hpp"
+#include "statistics.hpp"
+#include "survival.hpp"
+#include "strategy.hpp"
+#include "thread_pool.hpp"
 #include <iostream>
 #include <vector>
 #include <algorithm>
@@ -9,118 +21,649 @@
 #include <iomanip>
 #include <array>
 #include <limits>
+#include <memory>
+#include <sstream>
+#include <filesystem>
 
 using namespace BlockGame;
 
-/**
- * Simple strategy: pick a random legal move for any available piece
- */
-class RandomStrategy {
-public:
-    explicit RandomStrategy(uint64_t seed) : rng_(seed) {}
-
-    // Play a complete game, returns final score
-    int playGame() {
-        Game game(rng_());
-        
+void printUsage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [strategy] [num_runs] [options]\n";
+    std::cerr << "       " << prog << " --suite s1,s2,... [num_runs] [options]\n";
+    std::cerr << "  strategy: random, greedy or beam (default: random)\n";
+    std::cerr << "  num_runs: Number of simulation runs (default: 1000)\n";
+    std::cerr << "Options:\n";
+    std::cerr << "  --beam-width N     Boards kept per hand in beam search (default: 8)\n";
+    std::cerr << "  --beam-depth N     Hands searched including the current one (default: 2)\n";
+    std::cerr << "  --beam-samples N   Sampled future hand sequences per decision (default: 4)\n";
+    std::cerr << "  --beam-sweep W,..  Run beam once per listed width and report score vs time\n";
+    std::cerr << "  --threads N        Search threads, 0 = all cores (default: 0)\n";
+    std::cerr << "  --weights FILE     Heuristic weights file, e.g. from the tuner\n";
+    std::cerr << "  --evaluator NAME   Board evaluator for greedy/beam: heuristic, nn or ntuple\n";
+    std::cerr << "                     (default: heuristic)\n";
+    std::cerr << "  --nn-weights FILE  Value network weights for --evaluator nn\n";
+    std::cerr << "  --nn-random SEED   Use a random untrained network (plumbing/speed tests only)\n";
+    std::cerr << "  --nn-fp32          Run the network's hidden layer in fp32 instead of int8\n";
+    std::cerr << "  --ntuple-spec S    Pattern spec for a fresh --evaluator ntuple network\n";
+    std::cerr << "  --ntuple-weights F N-tuple network to load for --evaluator ntuple\n";
+    std::cerr << "  --ntuple-train N   Train the n-tuple network with N TD(0) self-play games first\n";
+    std::cerr << "  --ntuple-alpha A   TD(0) learning rate (default: 0.1)\n";
+    std::cerr << "  --ntuple-save F    Write the n-tuple network to F after training\n";
+    std::cerr << "  --endgame-build F  Solve every nearly full board reached in the games and\n";
+    std::cerr << "                     write them to tablebase F\n";
+    std::cerr << "  --endgame-empty N  Most empty squares a solved board may have (default: 10)\n";
+    std::cerr << "  --endgame-hands K  Hands the endgame solver looks ahead (default: 1)\n";
+    std::cerr << "  --endgame-score    Build expected points instead of survival probability\n";
+    std::cerr << "  --endgame-table F  Penalise risky boards found in survival tablebase F\n";
+    std::cerr << "  --endgame-penalty P Score cost of certain death for --endgame-table (default: 1000)\n";
+    std::cerr << "  --survival-weight W Add W * P(next hand fits) to the board evaluation\n";
+    std::cerr << "  --survival-samples N Sampled hands for --survival-weight, 0 = all (default: 64)\n";
+    std::cerr << "  --survival-report  Report how often the boards a strategy leaves can take the next hand\n";
+    std::cerr << "  --plain-order      Search placements in board order instead of line clears first in\n";
+    std::cerr << "                     --survival-report and --endgame-build, to compare their cutoff\n";
+    std::cerr << "                     statistics\n";
+    std::cerr << "  --hand-cache BITS  Share a 2^BITS entry hand feasibility cache between the\n";
+    std::cerr << "                     planners and games of the main run, 16 bytes per entry,\n";
+    std::cerr << "                     at most 28 (default: off)\n";
+    std::cerr << "  --perf-counters    Count cycles, instructions, branch and cache misses in the\n";
+    std::cerr << "                     main run and report them per game for every tenth of the run\n";
+    std::cerr << "  --seed N           Seed for game hands and strategies (default: random)\n";
+    std::cerr << "  --suite S1,S2,..   Play the same games with every strategy and compare\n";
+    std::cerr << "                     each against the first with paired differences\n";
+    std::cerr << "  --target-ci W      Stop once the 95% CI half-width on the mean (suite: on\n";
+    std::cerr << "                     every paired difference) is below W; num_runs is the cap\n";
+    std::cerr << "  --min-runs N       Games before --target-ci may stop (default: 30)\n";
+    std::cerr << "  --save-histogram F Write the score histogram to F for later merging\n";
+    std::cerr << "  --merge F1,F2,..   Print combined results of saved histograms and exit\n";
+    std::cerr << "  --format FMT       Summary format: text, json or csv (default: text); only the\n";
+    std::cerr << "                     main run and --merge support json and csv\n";
+    std::cerr << "  --records FILE     Write one record per game (seed, score, turns, moves,\n";
+    std::cerr << "                     wall time); JSON lines if FILE ends in .jsonl, else CSV\n";
+    std::cerr << "  --replay-out FILE  Record every game move by move in the binary replay format\n";
+    std::cerr << "  --snapshot-every N Store the board every N turns in replays (default: 0 = never)\n";
+    std::cerr << "  --verify-replay F  Replay every game in F through the engine, check scores, exit\n";
+    std::cerr << "  --export DIR       Write training samples (board, hand, move, return-to-go) as\n";
+    std::cerr << "                     fixed-stride shards, one per thread, plus DIR/index.txt\n";
+    std::cerr << "  --export-max N     Reservoir-sample at most N samples in total (default: 0 = all)\n";
+}
+
+std::vector<std::string> parseList(const std::string& text) {
+    std::vector<std::string> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back(item);
+    }
+    return values;
+}
+
+std::vector<int> parseIntList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+// Score vs time for a range of beam widths, every width plays the same games
+int runBeamSweep(const std::vector<int>& widths, BeamConfig config, int numRuns, uint64_t seed,
+                 const std::shared_ptr<const Evaluator>& evaluator) {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "═══════════════════════════════════════════════════════════════\n";
+    std::cout << "  BEAM SWEEP (depth " << config.depth << ", samples " << config.samples << ")\n";
+    std::cout << "═══════════════════════════════════════════════════════════════\n";
+    std::cout << "   Width        Mean         P50      StdDev     Time(s)   Games/s\n";
+    std::cout << "───────────────────────────────────────────────────────────────\n";
+
+    for (int width : widths) {
+        config.width = width;
+        auto strategy = makeStrategy("beam", seed, config, evaluator);
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<int> scores = runSimulations(*strategy, makeGameSeeds(seed, numRuns), false);
+        auto endTime = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = endTime - startTime;
+
+        Statistics stats = Statistics::compute(scores);
+        std::cout << "  " << std::setw(6) << width
+                  << std::setw(12) << stats.mean
+                  << std::setw(12) << stats.median
+                  << std::setw(12) << stats.stddev
+                  << std::setw(12) << elapsed.count()
+                  << std::setw(10) << (numRuns / elapsed.count()) << "\n" << std::flush;
+    }
+    std::cout << "═══════════════════════════════════════════════════════════════\n";
+    return 0;
+}
+
+// Stop rule for sequential runs: targetCi <= 0 disables early stopping
+struct StopRule {
+    double targetCi = 0;
+    int minRuns = 30;
+
+    [[nodiscard]] bool reached(const RunningStats& stats) const {
+        return targetCi > 0 && stats.count() >= static_cast<size_t>(minRuns) && stats.ciHalfWidth() < targetCi;
+    }
+};
+
+// Every strategy plays the identical list of game seeds, i.e. identical hand sequences.
+// The first strategy is the baseline for paired differences. Games are interleaved
+// across strategies so the run can stop as soon as every paired difference is resolved.
+int runSuite(const std::vector<std::string>& names, const BeamConfig& beamConfig, int numRuns, uint64_t seed,
+             const std::shared_ptr<const Evaluator>& evaluator, const StopRule& stopRule) {
+    const std::vector<uint64_t> gameSeeds = makeGameSeeds(seed, numRuns);
+    std::vector<std::unique_ptr<Strategy>> strategies;
+    std::vector<std::vector<int>> results(names.size());
+    std::vector<double> times(names.size(), 0.0);
+    std::vector<RunningStats> diffs(names.size());
+
+    for (const auto& name : names) {
+        strategies.push_back(makeStrategy(name, seed, beamConfig, evaluator));
+        if (!strategies.back()) {
+            std::cerr << "Error: strategy " << name << " not implemented\n";
+            return 1;
+        }
+    }
+    std::cout << "Running up to " << numRuns << " suite games with " << names.size() << " strategies...\n" << std::flush;
+
+    int played = 0;
+    for (int i = 0; i < numRuns; ++i) {
+        for (size_t s = 0; s < names.size(); ++s) {
+            auto startTime = std::chrono::high_resolution_clock::now();
+            Game game(gameSeeds[i]);
+            results[s].push_back(strategies[s]->playGame(game));
+            auto endTime = std::chrono::high_resolution_clock::now();
+            times[s] += std::chrono::duration<double>(endTime - startTime).count();
+        }
+        played++;
+
+        // With a single strategy the stop rule applies to its own mean
+        bool resolved = true;
+        if (names.size() == 1) {
+            diffs[0].add(results[0].back());
+            resolved = stopRule.reached(diffs[0]);
+        }
+        for (size_t s = 1; s < names.size(); ++s) {
+            diffs[s].add(static_cast<double>(results[s].back()) - results[0].back());
+            resolved = resolved && stopRule.reached(diffs[s]);
+        }
+
+        if (numRuns >= 10 && ((i + 1) % (numRuns / 10) == 0 || i == numRuns - 1)) {
+            std::cout << "\r  Games: " << (i + 1) << "/" << numRuns << std::flush;
+        }
+        if (stopRule.targetCi > 0 && resolved) {
+            std::cout << "\r  Target CI reached after " << played << " games" << std::flush;
+            break;
+        }
+    }
+    std::cout << "\n";
+    numRuns = played;
+
+    std::cout << "\n" << std::fixed << std::setprecision(2);
+    std::cout << "═══════════════════════════════════════════════════════════════\n";
+    std::cout << "  SUITE RESULTS (" << numRuns << " games, seed " << seed << ")\n";
+    std::cout << "═══════════════════════════════════════════════════════════════\n";
+    std::cout << "  Strategy          Mean     ±95% CI         P50      StdDev   Time(s)\n";
+    std::cout << "───────────────────────────────────────────────────────────────\n";
+    for (size_t s = 0; s < names.size(); ++s) {
+        std::vector<int> sorted = results[s];
+        Statistics stats = Statistics::compute(sorted);
+        double ci = numRuns > 1 ? Z_95 * stats.stddev * std::sqrt(1.0 / (numRuns - 1)) : 0;
+        std::cout << "  " << std::left << std::setw(10) << names[s] << std::right
+                  << std::setw(12) << stats.mean
+                  << std::setw(12) << ci
+                  << std::setw(12) << stats.median
+                  << std::setw(12) << stats.stddev
+                  << std::setw(10) << times[s] << "\n";
+    }
+
+    if (names.size() > 1) {
+        std::cout << "───────────────────────────────────────────────────────────────\n";
+        std::cout << "  Paired difference vs " << names[0] << "\n";
+        std::cout << "  Strategy          Diff          95% CI                 Corr\n";
+        for (size_t s = 1; s < names.size(); ++s) {
+            PairedStatistics paired = PairedStatistics::compute(results[s], results[0]);
+            std::ostringstream interval;
+            interval << std::fixed << std::setprecision(2) << "[" << paired.ciLow << ", " << paired.ciHigh << "]";
+            std::cout << "  " << std::left << std::setw(10) << names[s] << std::right
+                      << std::setw(12) << paired.meanDiff
+                      << "  " << std::setw(24) << interval.str()
+                      << std::setw(10) << paired.correlation
+                      << ((paired.ciLow > 0 || paired.ciHigh < 0) ? "  *" : "") << "\n";
+        }
+        std::cout << "  (* = interval excludes zero)\n";
+    }
+    std::cout << "═══════════════════════════════════════════════════════════════\n";
+    return 0;
+}
+
+// Self-play dataset export. Games are split statically across threads (game i goes to
+// thread i % T) so the shard contents only depend on the seed and thread count.
+int runExport(const std::string& strategyName, int numRuns, uint64_t seed, BeamConfig beamConfig,
+              const std::shared_ptr<const Evaluator>& evaluator, const std::string& dir, uint64_t maxSamples) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        std::cerr << "Error: cannot create " << dir << ": " << ec.message() << "\n";
+        return 1;
+    }
+
+    // Parallelism is across games, each strategy searches single threaded
+    ThreadPool pool(beamConfig.threads);
+    // A shard with a reservoir of 0 would keep everything, so never have more shards than samples
+    const int numShards =
+        maxSamples == 0 ? pool.size() : static_cast<int>(std::min<uint64_t>(pool.size(), maxSamples));
+    beamConfig.threads = 1;
+
+    const std::vector<uint64_t> gameSeeds = makeGameSeeds(seed, numRuns);
+    std::vector<std::string> shardNames(numShards);
+    std::vector<uint64_t> seen(numShards, 0), written(numShards, 0);
+    std::vector<char> ok(numShards, 1);
+
+    std::cout << "Exporting " << numRuns << " " << strategyName << " games to " << dir << " with "
+              << numShards << " threads...\n" << std::flush;
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    pool.parallelFor(numShards, [&](size_t shard, int) {
+        shardNames[shard] = "shard_" + std::to_string(shard) + ".bin";
+        // Split the budget exactly: the first maxSamples % numShards shards take one extra sample
+        const uint64_t shardCap = maxSamples / numShards + (shard < maxSamples % numShards ? 1 : 0);
+        DatasetWriter writer;
+        if (!writer.open(dir + "/" + shardNames[shard], shardCap, seed + shard)) {
+            ok[shard] = 0;
+            return;
+        }
+        auto strategy = makeStrategy(strategyName, seed + shard, beamConfig, evaluator);
+        std::vector<uint64_t> shardSeeds;
+        for (size_t i = shard; i < gameSeeds.size(); i += numShards) {
+            shardSeeds.push_back(gameSeeds[i]);
+        }
+        runSimulations(*strategy, shardSeeds, false, {}, &writer);
+        seen[shard] = writer.samplesSeen();
+        ok[shard] = writer.close();
+        written[shard] = writer.samplesWritten();
+    });
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = endTime - startTime;
+
+    for (int shard = 0; shard < numShards; ++shard) {
+        if (!ok[shard]) {
+            std::cerr << "Error: failed writing shard " << shard << " in " << dir << "\n";
+            return 1;
+        }
+    }
+    if (!writeDatasetIndex(dir, shardNames, written)) {
+        std::cerr << "Error: cannot write " << dir << "/index.txt\n";
+        return 1;
+    }
+
+    uint64_t totalSeen = 0, totalWritten = 0;
+    for (int shard = 0; shard < numShards; ++shard) {
+        totalSeen += seen[shard];
+        totalWritten += written[shard];
+    }
+    std::cout << "Exported " << totalWritten << " of " << totalSeen << " samples ("
+              << totalWritten * sizeof(DatasetSample) / 1024 << " KiB) in " << std::fixed << std::setprecision(2)
+              << elapsed.count() << "s\n";
+    return 0;
+}
+
+// Play games and solve every nearly full board they reach, then write the tablebase
+int runEndgameBuild(const std::string& strategyName, int numRuns, uint64_t seed, const BeamConfig& beamConfig,
+                    const std::shared_ptr<const Evaluator>& evaluator, const EndgameSolver::Config& config,
+                    const std::string& path) {
+    auto strategy = makeStrategy(strategyName, seed, beamConfig, evaluator);
+    if (!strategy) {
+        std::cerr << "Error: strategy " << strategyName << " not implemented\n";
+        return 1;
+    }
+
+    EndgameSolver solver(config);
+    const std::vector<uint64_t> gameSeeds = makeGameSeeds(seed, numRuns);
+    uint64_t positions = 0;
+    double totalValue = 0;
+
+    std::cout << "Solving boards with at most " << config.maxEmpty << " empty squares over " << config.hands
+              << " hands in " << numRuns << " " << strategyName << " games...\n" << std::flush;
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t gameSeed : gameSeeds) {
+        Game game(gameSeed);
         while (!game.isGameOver()) {
-            auto moves = game.getAllLegalMoves();
-            if (moves.empty()) break;
-            
-            // Pick a random legal move
-            std::uniform_int_distribution<size_t> dist(0, moves.size() - 1);
-            const Move& move = moves[dist(rng_)];
-            game.makeMove(move);
+            strategy->playTurn(game);
+            if (!game.isGameOver() && solver.inRange(game.board())) {
+                totalValue += solver.solve(game.board());
+                positions++;
+            }
         }
-        
-        return game.score();
     }
 
-private:
-    std::mt19937_64 rng_;
-};
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = endTime - startTime;
 
-/**
- * Statistics calculator
- */
-struct Statistics {
-    double min;      // P0
-    double p10;
-    double p25;
-    double median;   // P50
-    double p75;
-    double p90;
-    double max;      // P100
-    double mean;
-    double stddev;
-
-    static Statistics compute(std::vector<int>& scores) {
-        Statistics stats{};
-        
-        if (scores.empty()) return stats;
-        
-        // Sort for percentiles
-        std::sort(scores.begin(), scores.end());
-        
-        size_t n = scores.size();
-        
-        // Percentiles
-        stats.min = scores[0];
-        stats.p10 = percentile(scores, 10);
-        stats.p25 = percentile(scores, 25);
-        stats.median = percentile(scores, 50);
-        stats.p75 = percentile(scores, 75);
-        stats.p90 = percentile(scores, 90);
-        stats.max = scores[n - 1];
-        
-        // Mean
-        double sum = std::accumulate(scores.begin(), scores.end(), 0.0);
-        stats.mean = sum / n;
-        
-        // Standard deviation
-        double sqSum = 0;
-        for (int s : scores) {
-            double diff = s - stats.mean;
-            sqSum += diff * diff;
-        }
-        stats.stddev = std::sqrt(sqSum / n);
-        
-        return stats;
-    }
-
-private:
-    static double percentile(const std::vector<int>& sorted, double p) {
-        if (sorted.empty()) return 0;
-        if (sorted.size() == 1) return sorted[0];
-        
-        double idx = (p / 100.0) * (sorted.size() - 1);
-        size_t lo = static_cast<size_t>(idx);
-        size_t hi = lo + 1;
-        double frac = idx - lo;
-        
-        if (hi >= sorted.size()) return sorted[lo];
-        return sorted[lo] * (1 - frac) + sorted[hi] * frac;
+    if (!solver.save(path)) {
+        std::cerr << "Error: cannot write tablebase " << path << "\n";
+        return 1;
     }
-};
+    std::cout << "Solved " << positions << " positions (" << solver.size() << " distinct) in " << std::fixed
+              << std::setprecision(2) << elapsed.count() << "s, mean "
+              << (config.objective == EndgameSolver::Objective::SURVIVAL ? "survival " : "points ")
+              << std::setprecision(4) << (positions ? totalValue / positions : 0.0) << "\n";
+    std::cout << "Last-hand search (" << (config.clearingFirst ? "clears first" : "board order")
+              << "): " << solver.cutoffs().describe() << "\n";
+    std::cout << "Tablebase written to " << path << "\n";
+    return 0;
+}
 
-void printUsage(const char* prog) {
-    std::cerr << "Usage: " << prog << " [strategy] [num_runs]\n";
-    std::cerr << "  strategy: 'random' only for now (default: random)\n";
-    std::cerr << "  num_runs: Number of simulation runs (default: 1000)\n";
+// Exact survival probability of every board the strategy leaves after a hand
+int runSurvivalReport(const std::string& strategyName, int numRuns, uint64_t seed, const BeamConfig& beamConfig,
+                      const std::shared_ptr<const Evaluator>& evaluator, bool clearingFirst) {
+    auto strategy = makeStrategy(strategyName, seed, beamConfig, evaluator);
+    if (!strategy) {
+        std::cerr << "Error: strategy " << strategyName << " not implemented\n";
+        return 1;
+    }
+
+    SurvivalEstimator estimator;
+    estimator.setClearingFirst(clearingFirst);
+    RunningStats all, lastBoard, gameMinimum;
+    uint64_t risky = 0;
+    std::cout << "Measuring survival probability over " << numRuns << " " << strategyName << " games...\n" << std::flush;
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t gameSeed : makeGameSeeds(seed, numRuns)) {
+        Game game(gameSeed);
+        double last = 1, minimum = 1;
+        while (!game.isGameOver()) {
+            strategy->playTurn(game);
+            if (game.isGameOver()) break;
+            const double p = estimator.exact(game.board()).probability;
+            all.add(p);
+            risky += p < 0.5;
+            minimum = std::min(minimum, p);
+            last = p;
+        }
+        lastBoard.add(last);
+        gameMinimum.add(minimum);
+    }
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = endTime - startTime;
+
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "  Boards measured:            " << all.count() << " (" << std::setprecision(1)
+              << all.count() / elapsed.count() << "/s)\n" << std::setprecision(4);
+    std::cout << "  Mean P(next hand fits):     " << all.mean() << " +/- " << all.ciHalfWidth() << "\n";
+    std::cout << "  Boards with P < 0.5:        " << (all.count() ? 100.0 * risky / all.count() : 0.0) << "%\n";
+    std::cout << "  Mean P before the last hand: " << lastBoard.mean() << "\n";
+    std::cout << "  Mean lowest P per game:     " << gameMinimum.mean() << "\n";
+    std::cout << "  Search (" << (clearingFirst ? "clears first" : "board order") << "): "
+              << estimator.cutoffs().describe() << "\n";
+    return 0;
+}
+
+// Replay every recorded game through the engine and compare final scores
+int verifyReplay(const std::string& path) {
+    ReplayReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Error: cannot read replay file " << path << "\n";
+        return 1;
+    }
+
+    uint64_t games = 0, turns = 0, moves = 0, mismatches = 0;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    ReplayGame game;
+    while (reader.next(game)) {
+        games++;
+        turns += game.numTurns();
+        moves += game.numMoves();
+        int replayed = 0;
+        if (!replayGame(game, &replayed)) {
+            if (mismatches < 10) {
+                std::cerr << "  Mismatch in game " << games << " (seed " << game.seed() << "): recorded "
+                          << game.finalScore() << ", replayed " << replayed << "\n";
+            }
+            mismatches++;
+        }
+    }
+    auto endTime = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = endTime - startTime;
+
+    std::cout << "Verified " << games << " games (" << turns << " turns, " << moves << " moves) in "
+              << std::fixed << std::setprecision(3) << elapsed.count() << "s: "
+              << (mismatches == 0 ? "all scores reproduced" : std::to_string(mismatches) + " mismatches") << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
+
+enum class OutputFormat { TEXT, JSON, CSV };
+
+// Machine-readable summary, one JSON object or a CSV header plus one row
+void printSummaryData(OutputFormat format, const std::string& strategyName, uint64_t numRuns, const uint64_t* seed,
+                      long long elapsedMs, const Statistics& stats) {
+    const double gamesPerSec = elapsedMs > 0 ? numRuns * 1000.0 / elapsedMs : 0;
+    const std::vector<std::pair<const char*, double>> values = {
+        {"p0", stats.min}, {"p10", stats.p10}, {"p25", stats.p25}, {"p50", stats.median},
+        {"p75", stats.p75}, {"p90", stats.p90}, {"p100", stats.max},
+        {"mean", stats.mean}, {"stddev", stats.stddev},
+    };
+
+    std::cout << std::setprecision(6);
+    if (format == OutputFormat::JSON) {
+        std::cout << "{\"strategy\":\"" << strategyName << "\",\"runs\":" << numRuns;
+        if (seed) std::cout << ",\"seed\":" << *seed;
+        if (elapsedMs >= 0) std::cout << ",\"time_ms\":" << elapsedMs << ",\"games_per_sec\":" << gamesPerSec;
+        for (const auto& [name, value] : values) {
+            std::cout << ",\"" << name << "\":" << value;
+        }
+        std::cout << "}\n";
+    } else {
+        std::cout << "strategy,runs,seed,time_ms,games_per_sec";
+        for (const auto& [name, value] : values) std::cout << "," << name;
+        std::cout << "\n" << strategyName << "," << numRuns << ",";
+        if (seed) std::cout << *seed;
+        std::cout << ",";
+        if (elapsedMs >= 0) std::cout << elapsedMs << "," << gamesPerSec;
+        else std::cout << ",";
+        for (const auto& [name, value] : values) std::cout << "," << value;
+        std::cout << "\n";
+    }
+}
+
+// Summary box; seed and timing are omitted for merged results
+void printSummary(OutputFormat format, const std::string& strategyName, uint64_t numRuns, const uint64_t* seed,
+                  long long elapsedMs, const Statistics& stats) {
+    if (format != OutputFormat::TEXT) {
+        printSummaryData(format, strategyName, numRuns, seed, elapsedMs, stats);
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "═══════════════════════════════════════════\n";
+    std::cout << "           SIMULATION RESULTS              \n";
+    std::cout << "═══════════════════════════════════════════\n";
+    std::cout << "  Strategy:    " << strategyName << "\n";
+    std::cout << "  Runs:        " << numRuns << "\n";
+    if (seed) std::cout << "  Seed:        " << *seed << "\n";
+    if (elapsedMs >= 0) {
+        std::cout << "  Time:        " << elapsedMs << " ms\n";
+        std::cout << "  Games/sec:   " << (numRuns * 1000.0 / elapsedMs) << "\n";
+    }
+    std::cout << "───────────────────────────────────────────\n";
+    std::cout << "  P0   (min):  " << std::setw(10) << stats.min << "\n";
+    std::cout << "  P10:         " << std::setw(10) << stats.p10 << "\n";
+    std::cout << "  P25:         " << std::setw(10) << stats.p25 << "\n";
+    std::cout << "  P50  (med):  " << std::setw(10) << stats.median << "\n";
+    std::cout << "  P75:         " << std::setw(10) << stats.p75 << "\n";
+    std::cout << "  P90:         " << std::setw(10) << stats.p90 << "\n";
+    std::cout << "  P100 (max):  " << std::setw(10) << stats.max << "\n";
+    std::cout << "───────────────────────────────────────────\n";
+    std::cout << "  Mean:        " << std::setw(10) << stats.mean << "\n";
+    std::cout << "  Std Dev:     " << std::setw(10) << stats.stddev << "\n";
+    std::cout << "═══════════════════════════════════════════\n";
 }
 
 int main(int argc, char* argv[]) {
     int numRuns = 1000;
     std::string strategyName = "random";
+    BeamConfig beamConfig;
+    std::vector<int> sweepWidths;
+    std::string weightsPath;
+    std::string evaluatorName = "heuristic";
+    std::string nnWeightsPath;
+    bool nnRandom = false;
+    uint64_t nnRandomSeed = 0;
+    bool nnFp32 = false;
+    std::string endgameBuildPath;
+    std::string endgameTablePath;
+    EndgameSolver::Config endgameConfig;
+    double endgamePenalty = 1000;
+    double survivalWeight = 0;
+    int survivalSamples = 64;
+    bool survivalReport = false;
+    bool plainOrder = false;
+    int handCacheBits = 0;
+    std::string ntupleSpec = NTupleEvaluator::DEFAULT_SPEC;
+    std::string ntupleWeightsPath;
+    std::string ntupleSavePath;
+    int ntupleTrainGames = 0;
+    double ntupleAlpha = 0.1;
+    std::vector<std::string> suiteNames;
+    StopRule stopRule;
+    std::string histogramPath;
+    std::vector<std::string> mergePaths;
+    OutputFormat outputFormat = OutputFormat::TEXT;
+    std::string recordsPath;
+    std::string replayPath;
+    std::string verifyPath;
+    int snapshotInterval = 0;
+    std::string exportDir;
+    uint64_t exportMax = 0;
+    bool haveSeed = false;
+    uint64_t seed = 0;
+    bool perfCounters = false;
     
     // Parse arguments
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
-        if (arg == "random") {
+        if (arg == "random" || arg == "greedy" || arg == "beam") {
             strategyName = arg;
         } else if (arg == "-h" || arg == "--help") {
             printUsage(argv[0]);
             return 0;
+        } else if (arg == "--nn-fp32") {
+            nnFp32 = true;
+        } else if (arg == "--survival-report") {
+            survivalReport = true;
+        } else if (arg == "--plain-order") {
+            plainOrder = true;
+        } else if (arg == "--endgame-score") {
+            endgameConfig.objective = EndgameSolver::Objective::SCORE;
+        } else if (arg == "--perf-counters") {
+            perfCounters = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            if (i + 1 >= argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            std::string value = argv[++i];
+            try {
+                if (arg == "--beam-width") {
+                    beamConfig.width = std::stoi(value);
+                } else if (arg == "--beam-depth") {
+                    beamConfig.depth = std::stoi(value);
+                } else if (arg == "--beam-samples") {
+                    beamConfig.samples = std::stoi(value);
+                } else if (arg == "--beam-sweep") {
+                    sweepWidths = parseIntList(value);
+                } else if (arg == "--seed") {
+                    seed = std::stoull(value);
+                    haveSeed = true;
+                } else if (arg == "--suite") {
+                    suiteNames = parseList(value);
+                } else if (arg == "--target-ci") {
+                    stopRule.targetCi = std::stod(value);
+                } else if (arg == "--min-runs") {
+                    stopRule.minRuns = std::stoi(value);
+                } else if (arg == "--save-histogram") {
+                    histogramPath = value;
+                } else if (arg == "--merge") {
+                    mergePaths = parseList(value);
+                } else if (arg == "--format") {
+                    if (value == "text") {
+                        outputFormat = OutputFormat::TEXT;
+                    } else if (value == "json") {
+                        outputFormat = OutputFormat::JSON;
+                    } else if (value == "csv") {
+                        outputFormat = OutputFormat::CSV;
+                    } else {
+                        std::cerr << "Error: unknown format " << value << "\n";
+                        return 1;
+                    }
+                } else if (arg == "--replay-out") {
+                    replayPath = value;
+                } else if (arg == "--snapshot-every") {
+                    snapshotInterval = std::stoi(value);
+                } else if (arg == "--verify-replay") {
+                    verifyPath = value;
+                } else if (arg == "--export") {
+                    exportDir = value;
+                } else if (arg == "--export-max") {
+                    exportMax = std::stoull(value);
+                } else if (arg == "--records") {
+                    recordsPath = value;
+                } else if (arg == "--evaluator") {
+                    evaluatorName = value;
+                } else if (arg == "--nn-weights") {
+                    nnWeightsPath = value;
+                } else if (arg == "--nn-random") {
+                    nnRandom = true;
+                    nnRandomSeed = std::stoull(value);
+                } else if (arg == "--ntuple-spec") {
+                    ntupleSpec = value;
+                } else if (arg == "--ntuple-weights") {
+                    ntupleWeightsPath = value;
+                } else if (arg == "--ntuple-train") {
+                    ntupleTrainGames = std::stoi(value);
+                } else if (arg == "--ntuple-alpha") {
+                    ntupleAlpha = std::stod(value);
+                } else if (arg == "--ntuple-save") {
+                    ntupleSavePath = value;
+                } else if (arg == "--endgame-build") {
+                    endgameBuildPath = value;
+                } else if (arg == "--endgame-empty") {
+                    endgameConfig.maxEmpty = std::stoi(value);
+                } else if (arg == "--endgame-hands") {
+                    endgameConfig.hands = std::stoi(value);
+                } else if (arg == "--endgame-table") {
+                    endgameTablePath = value;
+                } else if (arg == "--endgame-penalty") {
+                    endgamePenalty = std::stod(value);
+                } else if (arg == "--survival-weight") {
+                    survivalWeight = std::stod(value);
+                } else if (arg == "--survival-samples") {
+                    survivalSamples = std::stoi(value);
+                } else if (arg == "--hand-cache") {
+                    handCacheBits = std::stoi(value);
+                    if (handCacheBits < 0 || handCacheBits > HandCache::MAX_BITS) {
+                        std::cerr << "Error: --hand-cache must be between 0 (off) and " << HandCache::MAX_BITS
+                                  << " (2^" << HandCache::MAX_BITS << " entries of 16 bytes)\n";
+                        return 1;
+                    }
+                } else if (arg == "--weights") {
+                    weightsPath = value;
+                } else if (arg == "--threads") {
+                    beamConfig.threads = std::stoi(value);
+                } else {
+                    std::cerr << "Error: unknown option " << arg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+            } catch (const std::exception& e) {
+                printUsage(argv[0]);
+                return 1;
+            }
         } else {
             try {
                 numRuns = std::stoi(arg);
@@ -135,64 +678,240 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    std::cout << "Running " << numRuns << " simulations with " << strategyName << " strategy...\n";
-    std::cout << std::flush;
-    
-    // Seed from random device
-    std::random_device rd;
-    uint64_t seed = rd();
-    
-    // Run simulations
-    std::vector<int> scores;
-    scores.reserve(numRuns);
-    
-    auto startTime = std::chrono::high_resolution_clock::now();
-    
-    if (strategyName == "random") {
-        RandomStrategy strategy(seed);
-        for (int i = 0; i < numRuns; ++i) {
-            int score = strategy.playGame();
-            scores.push_back(score);
-            
-            // Progress indicator
-            if (numRuns >= 10 && ((i + 1) % (numRuns / 10) == 0 || i == numRuns - 1)) {
-                int pct = (i + 1) * 100 / numRuns;
-                std::cout << "\r  Progress: " << std::setw(3) << pct << "% (" << (i + 1) << "/" << numRuns << ")" << std::flush;
+    if (!mergePaths.empty()) {
+        ScoreHistogram combined;
+        for (const auto& path : mergePaths) {
+            ScoreHistogram part;
+            if (!part.load(path)) {
+                std::cerr << "Error: cannot load histogram " << path << "\n";
+                return 1;
             }
+            combined.merge(part);
         }
+        printSummary(outputFormat, "merged (" + std::to_string(mergePaths.size()) + " files)", combined.count(), nullptr, -1,
+                     combined.statistics());
+        return 0;
+    }
+
+    // Only --merge and the main run print their summary in the other formats
+    const char* textOnlyMode = !verifyPath.empty()         ? "--verify-replay"
+                               : survivalReport            ? "--survival-report"
+                               : !endgameBuildPath.empty() ? "--endgame-build"
+                               : !suiteNames.empty()       ? "--suite"
+                               : !exportDir.empty()        ? "--export"
+                               : !sweepWidths.empty()      ? "--beam-sweep"
+                                                           : nullptr;
+    if (outputFormat != OutputFormat::TEXT && textOnlyMode) {
+        std::cerr << "Error: --format is not supported with " << textOnlyMode << "\n";
+        return 1;
+    }
+
+    if (!verifyPath.empty()) {
+        return verifyReplay(verifyPath);
+    }
+
+    // Seed from random device unless reproducing a run
+    if (!haveSeed) {
+        std::random_device rd;
+        seed = rd();
+    }
+
+    HeuristicWeights weights = HeuristicWeights::defaults();
+    if (!weightsPath.empty() && !weights.load(weightsPath)) {
+        std::cerr << "Error: cannot load weights from " << weightsPath << "\n";
+        return 1;
+    }
+    std::shared_ptr<const Evaluator> evaluator;
+    if (evaluatorName == "heuristic") {
+        evaluator = std::make_shared<HeuristicEvaluator>(weights);
+    } else if (evaluatorName == "nn") {
+        auto network = std::make_shared<NNEvaluator>();
+        if (nnRandom) {
+            if (!network->initRandom(NNEvaluator::INPUT_FIT_MASK, 128, 32, nnRandomSeed)) {
+                std::cerr << "Error: cannot initialize a random network\n";
+                return 1;
+            }
+        } else if (nnWeightsPath.empty() || !network->load(nnWeightsPath)) {
+            std::cerr << "Error: --evaluator nn needs --nn-weights FILE (or --nn-random SEED)\n";
+            return 1;
+        }
+        network->setPrecision(nnFp32 ? NNEvaluator::Precision::FP32 : NNEvaluator::Precision::INT8);
+        evaluator = network;
+    } else if (evaluatorName == "ntuple") {
+        auto network = std::make_shared<NTupleEvaluator>(ntupleSpec);
+        if (network->numPatterns() == 0) {
+            std::cerr << "Error: bad n-tuple spec " << ntupleSpec << "\n";
+            return 1;
+        }
+        if (!ntupleWeightsPath.empty() && !network->load(ntupleWeightsPath)) {
+            std::cerr << "Error: cannot load n-tuple network from " << ntupleWeightsPath << "\n";
+            return 1;
+        }
+        if (ntupleTrainGames > 0) {
+            std::cout << "Training n-tuple network (" << network->numLookups() << " lookups, "
+                      << network->numWeights() << " weights) for " << ntupleTrainGames << " games...\n";
+            const double mean = trainTD0(network, ntupleTrainGames, ntupleAlpha, seed ^ 0x5bd1e995);
+            std::cout << "Mean training score: " << mean << "\n";
+        }
+        if (!ntupleSavePath.empty() && !network->save(ntupleSavePath)) {
+            std::cerr << "Error: cannot write n-tuple network to " << ntupleSavePath << "\n";
+            return 1;
+        }
+        evaluator = network;
     } else {
+        std::cerr << "Error: unknown evaluator " << evaluatorName << "\n";
+        return 1;
+    }
+
+    if (!endgameTablePath.empty()) {
+        auto table = std::make_shared<EndgameTablebase>();
+        if (!table->open(endgameTablePath)) {
+            std::cerr << "Error: cannot read tablebase " << endgameTablePath << "\n";
+            return 1;
+        }
+        if (table->objective() != EndgameSolver::Objective::SURVIVAL) {
+            std::cerr << "Error: --endgame-table needs a survival tablebase\n";
+            return 1;
+        }
+        evaluator = std::make_shared<EndgameEvaluator>(evaluator, table, endgamePenalty);
+    }
+
+    if (survivalWeight != 0) {
+        evaluator = std::make_shared<SurvivalEvaluator>(evaluator, survivalWeight, survivalSamples);
+    }
+
+    if (survivalReport) {
+        return runSurvivalReport(strategyName, numRuns, seed, beamConfig, evaluator, !plainOrder);
+    }
+
+    if (!endgameBuildPath.empty()) {
+        if (endgameConfig.maxEmpty < 0) {
+            std::cerr << "Error: --endgame-empty must be at least 0\n";
+            return 1;
+        }
+        if (endgameConfig.hands < 1) {
+            std::cerr << "Error: --endgame-hands must be at least 1\n";
+            return 1;
+        }
+        endgameConfig.clearingFirst = !plainOrder;
+        return runEndgameBuild(strategyName, numRuns, seed, beamConfig, evaluator, endgameConfig, endgameBuildPath);
+    }
+
+    if (!suiteNames.empty()) {
+        return runSuite(suiteNames, beamConfig, numRuns, seed, evaluator, stopRule);
+    }
+
+    if (!exportDir.empty()) {
+        return runExport(strategyName, numRuns, seed, beamConfig, evaluator, exportDir, exportMax);
+    }
+
+    if (!sweepWidths.empty()) {
+        return runBeamSweep(sweepWidths, beamConfig, numRuns, seed, evaluator);
+    }
+
+    // Opened before the strategy so its search threads are counted too
+    PerfCounters counters;
+    if (perfCounters && !counters.open(PerfCounters::ALL_EVENTS, true)) {
+        std::cerr << "Warning: perf counters unavailable (" << counters.error() << ")\n";
+    }
+
+    auto strategy = makeStrategy(strategyName, seed, beamConfig, evaluator);
+    if (!strategy) {
         std::cerr << "Error: strategy " << strategyName << " not implemented\n";
         return 1;
     }
+    std::unique_ptr<HandCache> handCache;
+    if (handCacheBits > 0) {
+        handCache = std::make_unique<HandCache>(handCacheBits);
+        strategy->setHandCache(handCache.get());
+    }
+
+    RecordWriter records;
+    if (!recordsPath.empty()) {
+        const bool jsonl = recordsPath.size() >= 6 && recordsPath.compare(recordsPath.size() - 6, 6, ".jsonl") == 0;
+        if (!records.open(recordsPath, jsonl ? RecordWriter::Format::JSONL : RecordWriter::Format::CSV)) {
+            std::cerr << "Error: cannot open records file " << recordsPath << "\n";
+            return 1;
+        }
+    }
+
+    ReplayWriter replay;
+    if (!replayPath.empty()) {
+        const uint16_t interval = static_cast<uint16_t>(std::clamp(snapshotInterval, 0, 0xFFFF));
+        if (!replay.open(replayPath, static_cast<uint8_t>(strategyId(strategyName)), interval)) {
+            std::cerr << "Error: cannot open replay file " << replayPath << "\n";
+            return 1;
+        }
+    }
+
+    // Keep stdout clean for machine-readable output
+    const bool textOutput = outputFormat == OutputFormat::TEXT;
+    if (textOutput) {
+        std::cout << "Running " << numRuns << " simulations with " << strategyName << " strategy...\n";
+        std::cout << std::flush;
+    }
     
+    // Run simulations
+    auto startTime = std::chrono::high_resolution_clock::now();
+    RunningStats running;
+
+    // Counter rates per batch of games, printed after the summary
+    const uint64_t counterBatch = std::max(1, numRuns / 10);
+    std::vector<std::string> counterLines;
+    PerfCounters::Reading batchStart;
+    uint64_t batchGames = 0;
+    auto endCounterBatch = [&] {
+        const PerfCounters::Reading now = counters.read();
+        counterLines.push_back("  games " + std::to_string(running.count() - batchGames + 1) + "-" +
+                               std::to_string(running.count()) + ": " +
+                               (now - batchStart).describe(static_cast<double>(batchGames), "game"));
+        batchStart = now;
+        batchGames = 0;
+    };
+
+    counters.start();
+    ScoreHistogram histogram = streamSimulations(*strategy, seed, numRuns, textOutput, [&](const GameRecord& record) {
+        records.write(record);
+        running.add(record.score);
+        if (counters.available() && ++batchGames == counterBatch) endCounterBatch();
+        return stopRule.reached(running);
+    }, replayPath.empty() ? nullptr : &replay);
+    counters.stop();
+    if (counters.available() && batchGames > 0) endCounterBatch();
+    if (textOutput && histogram.count() < static_cast<uint64_t>(numRuns)) {
+        std::cout << "\r  Target CI reached after " << histogram.count() << " games" << std::flush;
+    }
+    numRuns = static_cast<int>(histogram.count());
     auto endTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
-    
-    std::cout << "\n\n";
+    if (textOutput) std::cout << "\n\n";
+
+    if (!replay.close()) {
+        std::cerr << "Error: failed writing replay to " << replayPath << "\n";
+        return 1;
+    }
+    if (!records.close()) {
+        std::cerr << "Error: failed writing records to " << recordsPath << "\n";
+        return 1;
+    }
     
     // Compute and display statistics
-    Statistics stats = Statistics::compute(scores);
-    
-    std::cout << std::fixed << std::setprecision(2);
-    std::cout << "═══════════════════════════════════════════\n";
-    std::cout << "           SIMULATION RESULTS              \n";
-    std::cout << "═══════════════════════════════════════════\n";
-    std::cout << "  Strategy:    " << strategyName << "\n";
-    std::cout << "  Runs:        " << numRuns << "\n";
-    std::cout << "  Time:        " << duration.count() << " ms\n";
-    std::cout << "  Games/sec:   " << (numRuns * 1000.0 / duration.count()) << "\n";
-    std::cout << "───────────────────────────────────────────\n";
-    std::cout << "  P0   (min):  " << std::setw(10) << stats.min << "\n";
-    std::cout << "  P10:         " << std::setw(10) << stats.p10 << "\n";
-    std::cout << "  P25:         " << std::setw(10) << stats.p25 << "\n";
-    std::cout << "  P50  (med):  " << std::setw(10) << stats.median << "\n";
-    std::cout << "  P75:         " << std::setw(10) << stats.p75 << "\n";
-    std::cout << "  P90:         " << std::setw(10) << stats.p90 << "\n";
-    std::cout << "  P100 (max):  " << std::setw(10) << stats.max << "\n";
-    std::cout << "───────────────────────────────────────────\n";
-    std::cout << "  Mean:        " << std::setw(10) << stats.mean << "\n";
-    std::cout << "  Std Dev:     " << std::setw(10) << stats.stddev << "\n";
-    std::cout << "═══════════════════════════════════════════\n";
+    const Statistics stats = histogram.statistics();
+    printSummary(outputFormat, strategyName, numRuns, &seed, duration.count(), stats);
+
+    if (counters.available()) {
+        // Machine-readable formats keep stdout to the summary
+        std::ostream& out = textOutput ? std::cout : std::cerr;
+        out << "\nPerf counters per game:\n";
+        for (const auto& line : counterLines) out << line << "\n";
+        out << "  all " << numRuns << " games: "
+            << counters.read().describe(static_cast<double>(numRuns), "game") << "\n";
+    }
+
+    if (!histogramPath.empty() && !histogram.save(histogramPath)) {
+        std::cerr << "Error: cannot write histogram to " << histogramPath << "\n";
+        return 1;
+    }
     
     return 0;
 }
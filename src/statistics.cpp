@@ -0,0 +1,232 @@
+#include "statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <new>
+#include <numeric>
+#include <sstream>
+
+namespace BlockGame {
+
+Statistics Statistics::compute(std::vector<int>& scores) {
+    Statistics stats{};
+    
+    if (scores.empty()) return stats;
+    
+    // Sort for percentiles
+    std::sort(scores.begin(), scores.end());
+    
+    size_t n = scores.size();
+    
+    // Percentiles
+    stats.min = scores[0];
+    stats.p10 = percentile(scores, 10);
+    stats.p25 = percentile(scores, 25);
+    stats.median = percentile(scores, 50);
+    stats.p75 = percentile(scores, 75);
+    stats.p90 = percentile(scores, 90);
+    stats.max = scores[n - 1];
+    
+    // Mean
+    double sum = std::accumulate(scores.begin(), scores.end(), 0.0);
+    stats.mean = sum / n;
+    
+    // Standard deviation
+    double sqSum = 0;
+    for (int s : scores) {
+        double diff = s - stats.mean;
+        sqSum += diff * diff;
+    }
+    stats.stddev = std::sqrt(sqSum / n);
+    
+    return stats;
+}
+
+double Statistics::percentile(const std::vector<int>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    if (sorted.size() == 1) return sorted[0];
+    
+    double idx = (p / 100.0) * (sorted.size() - 1);
+    size_t lo = static_cast<size_t>(idx);
+    size_t hi = lo + 1;
+    double frac = idx - lo;
+    
+    if (hi >= sorted.size()) return sorted[lo];
+    return sorted[lo] * (1 - frac) + sorted[hi] * frac;
+}
+
+bool ScoreHistogram::add(int score) {
+    if (score < 0 || score % SCORE_QUANTUM != 0) return false;
+    const size_t bin = static_cast<size_t>(score / SCORE_QUANTUM);
+    if (bin >= bins_.size()) {
+        bins_.resize(std::max(bin + 1, bins_.size() * 2), 0);
+    }
+    bins_[bin]++;
+    count_++;
+    return true;
+}
+
+void ScoreHistogram::merge(const ScoreHistogram& other) {
+    if (other.bins_.size() > bins_.size()) {
+        bins_.resize(other.bins_.size(), 0);
+    }
+    for (size_t i = 0; i < other.bins_.size(); ++i) {
+        bins_[i] += other.bins_[i];
+    }
+    count_ += other.count_;
+}
+
+double ScoreHistogram::scoreAtRank(uint64_t rank) const {
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bins_.size(); ++i) {
+        seen += bins_[i];
+        if (seen > rank) return static_cast<double>(i * SCORE_QUANTUM);
+    }
+    return 0;
+}
+
+double ScoreHistogram::percentile(double p) const {
+    if (count_ == 0) return 0;
+    if (count_ == 1) return scoreAtRank(0);
+
+    double idx = (p / 100.0) * (count_ - 1);
+    uint64_t lo = static_cast<uint64_t>(idx);
+    uint64_t hi = lo + 1;
+    double frac = idx - lo;
+
+    if (hi >= count_) return scoreAtRank(lo);
+    return scoreAtRank(lo) * (1 - frac) + scoreAtRank(hi) * frac;
+}
+
+Statistics ScoreHistogram::statistics() const {
+    Statistics stats{};
+    if (count_ == 0) return stats;
+
+    stats.min = scoreAtRank(0);
+    stats.p10 = percentile(10);
+    stats.p25 = percentile(25);
+    stats.median = percentile(50);
+    stats.p75 = percentile(75);
+    stats.p90 = percentile(90);
+    stats.max = scoreAtRank(count_ - 1);
+
+    double sum = 0;
+    for (size_t i = 0; i < bins_.size(); ++i) {
+        sum += static_cast<double>(bins_[i]) * (i * SCORE_QUANTUM);
+    }
+    stats.mean = sum / count_;
+
+    double sqSum = 0;
+    for (size_t i = 0; i < bins_.size(); ++i) {
+        double diff = static_cast<double>(i * SCORE_QUANTUM) - stats.mean;
+        sqSum += bins_[i] * diff * diff;
+    }
+    stats.stddev = std::sqrt(sqSum / count_);
+
+    return stats;
+}
+
+bool ScoreHistogram::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "count " << count_ << "\n";
+    for (size_t i = 0; i < bins_.size(); ++i) {
+        if (bins_[i] != 0) {
+            out << i * SCORE_QUANTUM << " " << bins_[i] << "\n";
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+bool ScoreHistogram::load(const std::string& path) {
+    std::ifstream in(path);
+    std::string key;
+    uint64_t expected;
+    if (!in || !(in >> key >> expected) || key != "count") return false;
+
+    ScoreHistogram loaded;
+    long long score;
+    uint64_t n;
+    while (in >> score >> n) {
+        // Only what add() accepts: a larger score cannot come from save() and would size the bins from the file
+        if (score < 0 || score > std::numeric_limits<int>::max() || score % SCORE_QUANTUM != 0) return false;
+        // Bins never exceed the total, so checking the total covers them too
+        if (__builtin_add_overflow(loaded.count_, n, &loaded.count_)) return false;
+        const size_t bin = static_cast<size_t>(score / SCORE_QUANTUM);
+        if (bin >= loaded.bins_.size()) {
+            try {
+                loaded.bins_.resize(bin + 1, 0);
+            } catch (const std::bad_alloc&) {
+                return false;
+            }
+        }
+        loaded.bins_[bin] += n;
+    }
+    // Stopped before the end: a line did not parse
+    if (!in.eof() || loaded.count_ != expected) return false;
+    *this = std::move(loaded);
+    return true;
+}
+
+PairedStatistics PairedStatistics::compute(const std::vector<int>& candidate, const std::vector<int>& baseline,
+                                           double z) {
+    PairedStatistics stats{};
+    const size_t n = std::min(candidate.size(), baseline.size());
+    stats.n = n;
+    if (n == 0) return stats;
+
+    double meanA = 0, meanB = 0;
+    for (size_t i = 0; i < n; ++i) {
+        stats.meanDiff += static_cast<double>(candidate[i]) - baseline[i];
+        meanA += candidate[i];
+        meanB += baseline[i];
+    }
+    stats.meanDiff /= n;
+    meanA /= n;
+    meanB /= n;
+
+    double sqDiff = 0, covAB = 0, varA = 0, varB = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double d = (static_cast<double>(candidate[i]) - baseline[i]) - stats.meanDiff;
+        double a = candidate[i] - meanA;
+        double b = baseline[i] - meanB;
+        sqDiff += d * d;
+        covAB += a * b;
+        varA += a * a;
+        varB += b * b;
+    }
+
+    stats.stddevDiff = n > 1 ? std::sqrt(sqDiff / (n - 1)) : 0;
+    stats.stdError = stats.stddevDiff / std::sqrt(static_cast<double>(n));
+    stats.ciLow = stats.meanDiff - z * stats.stdError;
+    stats.ciHigh = stats.meanDiff + z * stats.stdError;
+    stats.correlation = (varA > 0 && varB > 0) ? covAB / std::sqrt(varA * varB) : 0;
+    return stats;
+}
+
+void CutoffHistogram::merge(const CutoffHistogram& other) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    cutoffs_ += other.cutoffs_;
+    exhausted_ += other.exhausted_;
+    clearingCutoffs_ += other.clearingCutoffs_;
+    indexSum_ += other.indexSum_;
+}
+
+std::string CutoffHistogram::describe() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << "cutoffs " << cutoffs_ << ", mean index " << meanIndex() << ", by clearing moves "
+        << (cutoffs_ ? 100.0 * clearingCutoffs_ / cutoffs_ : 0.0) << "%, exhausted nodes " << exhausted_ << "\n";
+    out << std::setprecision(1) << "    index:";
+    for (int i = 0; i < BUCKETS; ++i) {
+        out << " " << i << (i == BUCKETS - 1 ? "+" : "") << ":" << (cutoffs_ ? 100.0 * counts_[i] / cutoffs_ : 0.0)
+            << "%";
+    }
+    return out.str();
+}
+
+} // namespace BlockGame
@@ -0,0 +1,257 @@
+#include "strategy.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace BlockGame {
+
+namespace {
+
+// Leaves are evaluated in chunks so each parallel task amortizes its dispatch cost
+constexpr size_t EVAL_CHUNK = 1024;
+
+void applyPlan(Game& game, const HandPlan& plan) {
+    for (int i = 0; i < plan.numMoves; ++i) {
+        game.makeMove(plan.moves[i]);
+    }
+}
+
+// Index of the leaf with the most points, used when the hand cannot be fully placed
+size_t bestPartialLeaf(const std::vector<HandPlanner::Node>& leaves) {
+    size_t best = 0;
+    for (size_t i = 1; i < leaves.size(); ++i) {
+        if (leaves[i].points > leaves[best].points) best = i;
+    }
+    return best;
+}
+
+} // anonymous namespace
+
+int Strategy::playGame(Game& game) {
+    if (handCache_) game.setHandCache(handCache_);
+    while (!game.isGameOver()) {
+        playTurn(game);
+    }
+    return game.score();
+}
+
+int remainingPieces(const Game& game, PieceType* out) {
+    int count = 0;
+    for (int i = 0; i < Game::HAND_SIZE; ++i) {
+        if (!game.handUsed()[i]) {
+            out[count++] = game.hand()[i];
+        }
+    }
+    return count;
+}
+
+void RandomStrategy::playTurn(Game& game) {
+    BG_TRACE_SCOPE("RandomStrategy::playTurn");
+    const int turn = game.turnNumber();
+    while (!game.isGameOver() && game.turnNumber() == turn) {
+        auto moves = game.getAllLegalMoves();
+        if (moves.empty()) break;
+
+        // Pick a random legal move
+        std::uniform_int_distribution<size_t> dist(0, moves.size() - 1);
+        game.makeMove(moves[dist(rng_)]);
+    }
+}
+
+void GreedyStrategy::setHandCache(HandCache* cache) {
+    Strategy::setHandCache(cache);
+    planner_.setCache(cache);
+}
+
+void GreedyStrategy::playTurn(Game& game) {
+    if (game.isGameOver()) return;
+    BG_TRACE_SCOPE("GreedyStrategy::playTurn");
+
+    PieceType pieces[Game::HAND_SIZE];
+    const int count = remainingPieces(game, pieces);
+    planner_.expand(game.board(), pieces, count);
+    const auto& leaves = planner_.leaves();
+
+    if (!planner_.complete()) {
+        applyPlan(game, planner_.plan(bestPartialLeaf(leaves)));
+        return;
+    }
+
+    size_t best = 0;
+    double bestValue = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        const double value = leaves[i].points + evaluator_->evaluate(Board(leaves[i].board));
+        if (value > bestValue) {
+            bestValue = value;
+            best = i;
+        }
+    }
+    applyPlan(game, planner_.plan(best));
+}
+
+BeamStrategy::BeamStrategy(std::shared_ptr<const Evaluator> evaluator, const BeamConfig& config, uint64_t seed)
+    : evaluator_(std::move(evaluator))
+    , config_(config)
+    , rng_(seed)
+    , pool_(config.threads)
+    , planners_(pool_.size())
+    , workerOutput_(pool_.size()) {
+    config_.width = std::max(1, config_.width);
+    config_.depth = std::max(1, config_.depth);
+    config_.samples = std::max(1, config_.samples);
+}
+
+void BeamStrategy::setHandCache(HandCache* cache) {
+    Strategy::setHandCache(cache);
+    rootPlanner_.setCache(cache);
+    for (auto& planner : planners_) {
+        planner.setCache(cache);
+    }
+}
+
+// Keep the best entry per distinct board, then the best `width` of those.
+// Ties are broken on board and root so the result does not depend on thread timing.
+void BeamStrategy::selectTop(std::vector<Entry>& entries) const {
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.board != b.board) return a.board < b.board;
+        if (a.value != b.value) return a.value > b.value;
+        return a.root < b.root;
+    });
+    auto last = std::unique(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.board == b.board;
+    });
+    entries.erase(last, entries.end());
+
+    auto byValue = [](const Entry& a, const Entry& b) {
+        if (a.value != b.value) return a.value > b.value;
+        return a.board < b.board;
+    };
+    if (entries.size() > static_cast<size_t>(config_.width)) {
+        std::nth_element(entries.begin(), entries.begin() + config_.width, entries.end(), byValue);
+        entries.resize(config_.width);
+    }
+    std::sort(entries.begin(), entries.end(), byValue);
+}
+
+void BeamStrategy::searchScenario(const std::vector<Entry>& roots) {
+    BG_TRACE_SCOPE("BeamStrategy::searchScenario");
+    beam_ = roots;
+
+    for (int layer = 1; layer < config_.depth; ++layer) {
+        // Same distribution as Game::drawHand
+        PieceType hand[Game::HAND_SIZE];
+        std::uniform_int_distribution<int> dist(0, NUM_PIECES - 1);
+        for (auto& piece : hand) {
+            piece = static_cast<PieceType>(dist(rng_));
+        }
+
+        for (auto& out : workerOutput_) {
+            out.clear();
+        }
+
+        pool_.parallelFor(beam_.size(), [&](size_t i, int worker) {
+            const Entry& entry = beam_[i];
+            auto& out = workerOutput_[worker];
+            if (!entry.alive) {
+                out.push_back(entry);
+                return;
+            }
+
+            // A hand already known not to fit skips the full expansion
+            HandPlanner& planner = planners_[worker];
+            bool feasible = true;
+            if (handCache_ && handCache_->probe(HandCache::makeKey(entry.board, hand, Game::HAND_SIZE), feasible) &&
+                !feasible) {
+                out.push_back({entry.board, entry.points - config_.deathPenalty, entry.points, entry.root, false});
+                return;
+            }
+            planner.expand(Board(entry.board), hand, Game::HAND_SIZE);
+            if (!planner.complete()) {
+                out.push_back({entry.board, entry.points - config_.deathPenalty, entry.points, entry.root, false});
+                return;
+            }
+
+            for (const auto& leaf : planner.leaves()) {
+                const int32_t points = entry.points + leaf.points;
+                const double value = points + evaluator_->evaluate(Board(leaf.board));
+                out.push_back({leaf.board, value, points, entry.root, true});
+            }
+        });
+
+        next_.clear();
+        for (const auto& out : workerOutput_) {
+            next_.insert(next_.end(), out.begin(), out.end());
+        }
+        selectTop(next_);
+        std::swap(beam_, next_);
+    }
+
+    // Roots whose lines were all pruned score just below the worst survivor
+    const double ninf = -std::numeric_limits<double>::infinity();
+    std::vector<double> best(roots.size(), ninf);
+    double worst = std::numeric_limits<double>::infinity();
+    for (const auto& entry : beam_) {
+        best[entry.root] = std::max(best[entry.root], entry.value);
+        worst = std::min(worst, entry.value);
+    }
+    for (size_t k = 0; k < roots.size(); ++k) {
+        totals_[k] += (best[k] == ninf) ? worst - 1.0 : best[k];
+    }
+}
+
+void BeamStrategy::playTurn(Game& game) {
+    if (game.isGameOver()) return;
+    BG_TRACE_SCOPE("BeamStrategy::playTurn");
+
+    PieceType pieces[Game::HAND_SIZE];
+    const int count = remainingPieces(game, pieces);
+    rootPlanner_.expand(game.board(), pieces, count);
+    const auto& leaves = rootPlanner_.leaves();
+
+    if (!rootPlanner_.complete()) {
+        applyPlan(game, rootPlanner_.plan(bestPartialLeaf(leaves)));
+        return;
+    }
+
+    // Evaluate every distinct board reachable with the current hand
+    rootValues_.resize(leaves.size());
+    const size_t numChunks = (leaves.size() + EVAL_CHUNK - 1) / EVAL_CHUNK;
+    pool_.parallelFor(numChunks, [&](size_t chunk, int) {
+        const size_t end = std::min(leaves.size(), (chunk + 1) * EVAL_CHUNK);
+        for (size_t i = chunk * EVAL_CHUNK; i < end; ++i) {
+            rootValues_[i] = leaves[i].points + evaluator_->evaluate(Board(leaves[i].board));
+        }
+    });
+
+    std::vector<Entry> roots;
+    roots.reserve(leaves.size());
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        roots.push_back({leaves[i].board, rootValues_[i], leaves[i].points, static_cast<int32_t>(i), true});
+    }
+    selectTop(roots);
+
+    // Lookahead: beam entries refer to their root by position in `roots`
+    if (config_.depth > 1 && roots.size() > 1) {
+        std::vector<int32_t> leafIndex(roots.size());
+        for (size_t k = 0; k < roots.size(); ++k) {
+            leafIndex[k] = roots[k].root;
+            roots[k].root = static_cast<int32_t>(k);
+        }
+
+        totals_.assign(roots.size(), 0.0);
+        for (int s = 0; s < config_.samples; ++s) {
+            searchScenario(roots);
+        }
+
+        size_t best = 0;
+        for (size_t k = 1; k < roots.size(); ++k) {
+            if (totals_[k] > totals_[best]) best = k;
+        }
+        applyPlan(game, rootPlanner_.plan(leafIndex[best]));
+        return;
+    }
+
+    applyPlan(game, rootPlanner_.plan(roots[0].root));
+}
+
+} // namespace BlockGame
@@ -0,0 +1,223 @@
+#include "survival.hpp"
+#include "statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace BlockGame {
+
+namespace {
+
+// Fewest empty squares in any row or column, i.e. the least it takes to clear a line
+int minSquaresToClear(uint64_t board) {
+    int best = 8;
+    for (int i = 0; i < 8; ++i) {
+        best = std::min(best, __builtin_popcountll(Board::rowMask(i) & ~board));
+        best = std::min(best, __builtin_popcountll(Board::colMask(i) & ~board));
+    }
+    return best;
+}
+
+inline int pieceSize(int type) {
+    return __builtin_popcountll(getPiece(static_cast<PieceType>(type)).baseMask);
+}
+
+} // anonymous namespace
+
+void SurvivalEstimator::prepare(uint64_t board) {
+    if (boardValid_ && board_ == board) return;
+    const Board b(board);
+    for (int type = 0; type < NUM_PIECES; ++type) {
+        fits_[type] = b.fitMask(getPiece(static_cast<PieceType>(type)));
+    }
+    canClear_.fill(-1);
+    minToClear_ = minSquaresToClear(board);
+    board_ = board;
+    boardValid_ = true;
+}
+
+bool SurvivalEstimator::canClear(int type) {
+    if (canClear_[type] < 0) {
+        const Piece& piece = getPiece(static_cast<PieceType>(type));
+        canClear_[type] = Board(board_).clearingFits(piece, fits_[type]) != 0;
+    }
+    return canClear_[type] != 0;
+}
+
+bool SurvivalEstimator::canPlacePair(uint64_t board, int x, int y) {
+    if (x > y) std::swap(x, y);
+    const Board b(board);
+
+    // Usually the first spot tried works, which is cheaper than a cache probe
+    const Piece& px = getPiece(static_cast<PieceType>(x));
+    const uint64_t fitsX = b.fitMask(px);
+    if (fitsX) {
+        const uint64_t clearing = clearingFits(b, px, fitsX);
+        const int pos = __builtin_ctzll(clearing ? clearing : fitsX);
+        Board child = b;
+        const int lines = child.placeAndClear(px.shiftToUnsafe(pos / 8, pos % 8));
+        if (child.fitMask(getPiece(static_cast<PieceType>(y))) != 0) {
+            cutoffs_.cutoff(0, lines > 0);
+            return true;
+        }
+    }
+
+    const uint16_t pieces = static_cast<uint16_t>(x * NUM_PIECES + y + 1);
+    const uint64_t hash = (board ^ (static_cast<uint64_t>(pieces) << 40)) * 0x9e3779b97f4a7c15ULL;
+    PairEntry& entry = pairCache_[(hash >> 32) & (pairCache_.size() - 1)];
+    if (entry.board == board && entry.pieces == pieces) return entry.result;
+
+    bool found = false;
+    int tried = 0;
+    for (int order = 0; order < (x == y ? 1 : 2) && !found; ++order) {
+        const Piece& first = getPiece(static_cast<PieceType>(order == 0 ? x : y));
+        const Piece& second = getPiece(static_cast<PieceType>(order == 0 ? y : x));
+        const uint64_t fits = b.fitMask(first);
+        const uint64_t clearing = clearingFits(b, first, fits);
+        for (uint64_t group : {clearing, fits & ~clearing}) {
+            for (; group && !found; group &= group - 1) {
+                const int pos = __builtin_ctzll(group);
+                Board child = b;
+                const int lines = child.placeAndClear(first.shiftToUnsafe(pos / 8, pos % 8));
+                found = child.fitMask(second) != 0;
+                if (found) cutoffs_.cutoff(tried, lines > 0);
+                tried++;
+            }
+        }
+    }
+    if (!found) cutoffs_.exhausted();
+
+    entry = {board, pieces, found};
+    return found;
+}
+
+bool SurvivalEstimator::canPlaceHand(const Board& board, PieceType a, PieceType b, PieceType c) {
+    prepare(board.data());
+    const int pieces[3] = {a, b, c};
+
+    // Squares only ever open up by clearing a line, so a piece that fits nowhere
+    // needs the pieces placed before it to complete one
+    int unfit = 0, fit[3], numFit = 0;
+    for (int p : pieces) {
+        if (fits_[p] == 0) {
+            unfit++;
+        } else {
+            fit[numFit++] = p;
+        }
+    }
+    if (unfit == 3) return false;
+    if (unfit == 2 && !canClear(fit[0])) return false;
+    if (unfit == 1 && pieceSize(fit[0]) + pieceSize(fit[1]) < minToClear_) return false;
+
+    int tried = 0;
+    for (int i = 0; i < 3; ++i) {
+        const int first = pieces[i];
+        if (fits_[first] == 0 || std::find(pieces, pieces + i, first) != pieces + i) continue;
+        const int x = pieces[(i + 1) % 3];
+        const int y = pieces[(i + 2) % 3];
+        const Piece& piece = getPiece(static_cast<PieceType>(first));
+        const uint64_t clearing = clearingFits(Board(board_), piece, fits_[first]);
+        for (uint64_t group : {clearing, fits_[first] & ~clearing}) {
+            for (; group; group &= group - 1) {
+                const int pos = __builtin_ctzll(group);
+                Board child(board_);
+                const int lines = child.placeAndClear(piece.shiftToUnsafe(pos / 8, pos % 8));
+                if (canPlacePair(child.data(), x, y)) {
+                    cutoffs_.cutoff(tried, lines > 0);
+                    return true;
+                }
+                tried++;
+            }
+        }
+    }
+    cutoffs_.exhausted();
+    return false;
+}
+
+SurvivalEstimate SurvivalEstimator::exact(const Board& board) {
+    prepare(board.data());
+    uint64_t weighted = 0, multisets = 0, total = 0;
+
+    // Most hands fit the first way tried: a at its first spot, then b at its first spot,
+    // then anywhere for c. Those boards are shared by every hand with the same a and b,
+    // so build them once per prefix and fall back to the full search only on a miss.
+    for (int a = 0; a < NUM_PIECES; ++a) {
+        Board afterA(board_);
+        const bool haveA = fits_[a] != 0;
+        if (haveA) {
+            const int pos = __builtin_ctzll(fits_[a]);
+            afterA.placeAndClear(getPiece(static_cast<PieceType>(a)).shiftToUnsafe(pos / 8, pos % 8));
+        }
+        for (int b = a; b < NUM_PIECES; ++b) {
+            Board afterAB = afterA;
+            bool haveAB = false;
+            if (haveA) {
+                const Piece& pb = getPiece(static_cast<PieceType>(b));
+                const uint64_t fits = afterA.fitMask(pb);
+                if (fits) {
+                    const int pos = __builtin_ctzll(fits);
+                    afterAB.placeAndClear(pb.shiftToUnsafe(pos / 8, pos % 8));
+                    haveAB = true;
+                }
+            }
+            for (int c = b; c < NUM_PIECES; ++c) {
+                total++;
+                const bool fits = (haveAB && afterAB.fitMask(getPiece(static_cast<PieceType>(c))) != 0) ||
+                                  canPlaceHand(board, static_cast<PieceType>(a), static_cast<PieceType>(b),
+                                               static_cast<PieceType>(c));
+                if (fits) {
+                    weighted += (a == c) ? 1 : (a == b || b == c) ? 3 : 6;
+                    multisets++;
+                }
+            }
+        }
+    }
+
+    SurvivalEstimate result;
+    result.probability = static_cast<double>(weighted) / (static_cast<double>(NUM_PIECES) * NUM_PIECES * NUM_PIECES);
+    result.lower = result.upper = result.probability;
+    result.multisetFraction = static_cast<double>(multisets) / total;
+    result.handsChecked = total;
+    return result;
+}
+
+SurvivalEstimate SurvivalEstimator::sampled(const Board& board, int samples, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> dist(0, NUM_PIECES - 1);
+    int successes = 0;
+    for (int s = 0; s < samples; ++s) {
+        const auto a = static_cast<PieceType>(dist(rng));
+        const auto b = static_cast<PieceType>(dist(rng));
+        const auto c = static_cast<PieceType>(dist(rng));
+        successes += canPlaceHand(board, a, b, c);
+    }
+
+    SurvivalEstimate result;
+    result.handsChecked = samples;
+    if (samples <= 0) return result;
+
+    const double n = samples;
+    const double p = successes / n;
+    result.probability = p;
+
+    // Wilson score interval: stays inside [0, 1] and is sensible when p is near 0 or 1.
+    // Its centre is pulled towards 1/2, so only the bounds come from it
+    const double z2 = Z_95 * Z_95;
+    const double denominator = 1 + z2 / n;
+    const double centre = (p + z2 / (2 * n)) / denominator;
+    const double halfWidth = Z_95 * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / denominator;
+    result.lower = std::max(0.0, centre - halfWidth);
+    result.upper = std::min(1.0, centre + halfWidth);
+    return result;
+}
+
+double SurvivalEvaluator::evaluate(const Board& board) const {
+    // Fixed seed: every board is checked against the same sampled hands
+    constexpr uint64_t SAMPLE_SEED = 0x243f6a8885a308d3ULL;
+    thread_local SurvivalEstimator estimator;
+    const double p = samples_ > 0 ? estimator.sampled(board, samples_, SAMPLE_SEED).probability
+                                  : estimator.exact(board).probability;
+    return base_->evaluate(board) + weight_ * p;
+}
+
+} // namespace BlockGame
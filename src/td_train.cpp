@@ -0,0 +1,397 @@
+#include "evaluator.hpp"
+#include "ntuple.hpp"
+#include "simulation.hpp"
+#include "statistics.hpp"
+#include "strategy.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace BlockGame;
+
+/**
+ * Value function trained by TD(lambda), shared by all training threads.
+ *
+ * The value of a board is linear in its features: sum of weight[index] * value
+ * over a sparse list of (index, value) pairs. For the n-tuple network every
+ * lookup is a feature with value 1; for the linear model the features are the
+ * heuristic feature vector. Weights are read and written with relaxed atomics
+ * and no locks (Hogwild): concurrent updates to the same weight may overwrite
+ * each other, which SGD tolerates, but no read ever sees a torn value.
+ */
+class TDModel : public Evaluator {
+public:
+    using Features = std::vector<std::pair<uint32_t, float>>;
+
+    virtual void features(const Board& board, Features& out) const = 0;
+
+    // Plain copy for evaluation suites. Only call while no training thread is running.
+    [[nodiscard]] virtual std::shared_ptr<const Evaluator> freeze() const = 0;
+    [[nodiscard]] virtual bool save(const std::string& path) const = 0;
+    [[nodiscard]] virtual const char* extension() const = 0;
+
+    [[nodiscard]] double evaluate(const Board& board) const override {
+        thread_local Features scratch;
+        features(board, scratch);
+        return value(scratch);
+    }
+
+    [[nodiscard]] double value(const Features& f) const {
+        double v = 0;
+        for (const auto& [index, x] : f) {
+            v += std::atomic_ref<float>(weights_[index]).load(std::memory_order_relaxed) * x;
+        }
+        return v;
+    }
+
+    // w += step * f
+    void add(const Features& f, double step) {
+        for (const auto& [index, x] : f) {
+            std::atomic_ref<float> w(weights_[index]);
+            w.store(w.load(std::memory_order_relaxed) + static_cast<float>(step * x), std::memory_order_relaxed);
+        }
+    }
+
+protected:
+    float* weights_ = nullptr;
+};
+
+class NTupleModel : public TDModel {
+public:
+    explicit NTupleModel(NTupleEvaluator network) : network_(std::move(network)) {
+        weights_ = network_.weights();
+    }
+
+    void features(const Board& board, Features& out) const override {
+        const uint64_t bits = board.data();
+        out.resize(network_.numLookups());
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = {network_.lookupIndex(i, bits), 1.0f};
+        }
+    }
+
+    [[nodiscard]] std::shared_ptr<const Evaluator> freeze() const override {
+        return std::make_shared<NTupleEvaluator>(network_);
+    }
+
+    [[nodiscard]] bool save(const std::string& path) const override { return network_.save(path); }
+    [[nodiscard]] const char* extension() const override { return ".bin"; }
+
+private:
+    NTupleEvaluator network_;
+};
+
+class LinearModel : public TDModel {
+public:
+    explicit LinearModel(const HeuristicWeights& initial) {
+        for (int i = 0; i < NUM_FEATURES; ++i) w_[i] = static_cast<float>(initial.w[i]);
+        weights_ = w_.data();
+    }
+
+    void features(const Board& board, Features& out) const override {
+        const FeatureVector f = computeFeatures(board);
+        out.resize(NUM_FEATURES);
+        for (int i = 0; i < NUM_FEATURES; ++i) {
+            out[i] = {static_cast<uint32_t>(i), static_cast<float>(f[i])};
+        }
+    }
+
+    [[nodiscard]] std::shared_ptr<const Evaluator> freeze() const override {
+        return std::make_shared<HeuristicEvaluator>(current());
+    }
+
+    [[nodiscard]] bool save(const std::string& path) const override { return current().save(path); }
+    [[nodiscard]] const char* extension() const override { return ".txt"; }
+
+private:
+    std::array<float, NUM_FEATURES> w_{};
+
+    [[nodiscard]] HeuristicWeights current() const {
+        HeuristicWeights weights;
+        for (int i = 0; i < NUM_FEATURES; ++i) weights.w[i] = w_[i];
+        return weights;
+    }
+};
+
+struct TDConfig {
+    std::string model = "ntuple";
+    std::string spec = NTupleEvaluator::DEFAULT_SPEC;
+    std::string initPath;           // Starting weights, empty for zeros / heuristic defaults
+    std::string strategy = "greedy";
+    int games = 10000;              // Training games in total
+    double alpha = 0.1;
+    double lambda = 0.5;
+    int checkpointEvery = 1000;     // Training games between snapshots and evaluation suites
+    int evalGames = 200;            // Games per evaluation suite, 0 to skip
+    uint64_t seed = 1;
+    int threads = 0;
+    std::string snapshotDir;        // Write every checkpoint's weights here if set
+    std::string outputPath;         // Best weights by evaluation score
+};
+
+// Number of past afterstates an update reaches, until lambda^k drops below 1e-3
+int traceLength(double lambda) {
+    int length = 1;
+    for (double decay = lambda; decay >= 1e-3 && length < 64; decay *= lambda) length++;
+    return length;
+}
+
+/**
+ * One self-play game with online TD(lambda) on afterstates.
+ *
+ * After every hand, the error of the previous afterstate's value against the
+ * points earned plus the new afterstate's value (or just the points if the game
+ * ended) is applied to the last few afterstates with weight lambda^k, the
+ * backward view of TD(lambda) truncated where the trace becomes negligible.
+ * Steps are normalised by the squared feature norm so one alpha suits both models.
+ */
+int trainGame(TDModel& model, Strategy& player, uint64_t seed, const TDConfig& config, int maxTrace) {
+    struct TraceEntry {
+        TDModel::Features features;
+        double norm = 0;
+    };
+    thread_local std::vector<TraceEntry> trace;
+    trace.resize(maxTrace);
+    int traceSize = 0;
+    int head = 0;   // Most recent afterstate
+
+    Game game(seed);
+    while (!game.isGameOver()) {
+        const int before = game.score();
+        player.playTurn(game);
+        const int reward = game.score() - before;
+
+        if (traceSize > 0) {
+            const double target = reward + (game.isGameOver() ? 0.0 : model.evaluate(game.board()));
+            const double delta = target - model.value(trace[head].features);
+            double decay = 1;
+            for (int k = 0; k < traceSize; ++k) {
+                const TraceEntry& entry = trace[(head - k + maxTrace) % maxTrace];
+                model.add(entry.features, config.alpha * decay * delta / (1 + entry.norm));
+                decay *= config.lambda;
+            }
+        }
+
+        if (!game.isGameOver()) {
+            head = (head + 1) % maxTrace;
+            TraceEntry& entry = trace[head];
+            model.features(game.board(), entry.features);
+            entry.norm = 0;
+            for (const auto& [index, x] : entry.features) entry.norm += static_cast<double>(x) * x;
+            traceSize = std::min(traceSize + 1, maxTrace);
+        }
+    }
+    return game.score();
+}
+
+// Fixed seeded suite with a frozen copy of the weights
+RunningStats evaluateSuite(const std::shared_ptr<const Evaluator>& evaluator, const std::vector<uint64_t>& seeds,
+                           const TDConfig& config, ThreadPool& pool) {
+    BeamConfig beamConfig;
+    beamConfig.threads = 1;
+    std::vector<int> scores(seeds.size());
+    pool.parallelFor(seeds.size(), [&](size_t g, int) {
+        auto strategy = makeStrategy(config.strategy, seeds[g], beamConfig, evaluator);
+        Game game(seeds[g]);
+        scores[g] = strategy->playGame(game);
+    });
+    RunningStats stats;
+    for (int score : scores) stats.add(score);
+    return stats;
+}
+
+void printUsage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n";
+    std::cerr << "  --model NAME       ntuple or linear (default: ntuple)\n";
+    std::cerr << "  --spec SPEC        N-tuple pattern spec (default: " << NTupleEvaluator::DEFAULT_SPEC << ")\n";
+    std::cerr << "  --init FILE        Starting weights (n-tuple network or heuristic weights file)\n";
+    std::cerr << "  --strategy NAME    Player using the weights: greedy or beam (default: greedy)\n";
+    std::cerr << "  --games N          Training games (default: 10000)\n";
+    std::cerr << "  --alpha A          Learning rate (default: 0.1)\n";
+    std::cerr << "  --lambda L         Trace decay, 0 = TD(0) (default: 0.5)\n";
+    std::cerr << "  --checkpoint-every N  Games between checkpoints (default: 1000)\n";
+    std::cerr << "  --eval-games N     Seeded games per checkpoint evaluation, 0 = none (default: 200)\n";
+    std::cerr << "  --seed N           Seed for training and evaluation games (default: 1)\n";
+    std::cerr << "  --threads N        Worker threads, 0 = all cores (default: 0)\n";
+    std::cerr << "  --snapshot-dir DIR Write the weights of every checkpoint into DIR\n";
+    std::cerr << "  --output FILE      Best weights by evaluation score\n";
+    std::cerr << "                     (default: td_weights.bin or td_weights.txt)\n";
+}
+
+int main(int argc, char* argv[]) {
+    TDConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--model") {
+                config.model = value;
+            } else if (arg == "--spec") {
+                config.spec = value;
+            } else if (arg == "--init") {
+                config.initPath = value;
+            } else if (arg == "--strategy") {
+                config.strategy = value;
+            } else if (arg == "--games") {
+                config.games = std::stoi(value);
+            } else if (arg == "--alpha") {
+                config.alpha = std::stod(value);
+            } else if (arg == "--lambda") {
+                config.lambda = std::stod(value);
+            } else if (arg == "--checkpoint-every") {
+                config.checkpointEvery = std::stoi(value);
+            } else if (arg == "--eval-games") {
+                config.evalGames = std::stoi(value);
+            } else if (arg == "--seed") {
+                config.seed = std::stoull(value);
+            } else if (arg == "--threads") {
+                config.threads = std::stoi(value);
+            } else if (arg == "--snapshot-dir") {
+                config.snapshotDir = value;
+            } else if (arg == "--output") {
+                config.outputPath = value;
+            } else {
+                std::cerr << "Error: unknown option " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.strategy != "greedy" && config.strategy != "beam") {
+        std::cerr << "Error: strategy " << config.strategy << " does not use an evaluator\n";
+        return 1;
+    }
+    if (config.games <= 0 || config.checkpointEvery <= 0 || config.evalGames < 0 || config.lambda < 0 ||
+        config.lambda >= 1) {
+        std::cerr << "Error: need games > 0, checkpoint-every > 0, eval-games >= 0 and 0 <= lambda < 1\n";
+        return 1;
+    }
+
+    std::unique_ptr<TDModel> model;
+    if (config.model == "ntuple") {
+        NTupleEvaluator network(config.spec);
+        if (network.numPatterns() == 0) {
+            std::cerr << "Error: bad n-tuple spec " << config.spec << "\n";
+            return 1;
+        }
+        if (!config.initPath.empty() && !network.load(config.initPath)) {
+            std::cerr << "Error: cannot load n-tuple network from " << config.initPath << "\n";
+            return 1;
+        }
+        std::cout << "N-tuple network: " << network.numPatterns() << " patterns, " << network.numLookups()
+                  << " lookups, " << network.numWeights() << " weights\n";
+        model = std::make_unique<NTupleModel>(std::move(network));
+    } else if (config.model == "linear") {
+        HeuristicWeights weights = HeuristicWeights::defaults();
+        if (!config.initPath.empty() && !weights.load(config.initPath)) {
+            std::cerr << "Error: cannot load weights from " << config.initPath << "\n";
+            return 1;
+        }
+        model = std::make_unique<LinearModel>(weights);
+    } else {
+        std::cerr << "Error: unknown model " << config.model << "\n";
+        return 1;
+    }
+    if (config.outputPath.empty()) {
+        config.outputPath = std::string("td_weights") + model->extension();
+    }
+    if (!config.snapshotDir.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(config.snapshotDir, ec);
+        if (ec) {
+            std::cerr << "Error: cannot create " << config.snapshotDir << ": " << ec.message() << "\n";
+            return 1;
+        }
+    }
+
+    ThreadPool pool(config.threads);
+    const int maxTrace = traceLength(config.lambda);
+
+    // The model is owned here; players hold a non-owning pointer to it
+    std::shared_ptr<const Evaluator> shared(model.get(), [](const Evaluator*) {});
+    BeamConfig beamConfig;
+    beamConfig.threads = 1;
+    std::vector<std::unique_ptr<Strategy>> players(pool.size());
+    for (int w = 0; w < pool.size(); ++w) {
+        players[w] = makeStrategy(config.strategy, config.seed + w, beamConfig, shared);
+    }
+
+    const std::vector<uint64_t> evalSeeds = makeGameSeeds(config.seed ^ 0x9e3779b97f4a7c15ULL, config.evalGames);
+    double bestMean = -1;
+
+    std::cout << "TD(" << config.lambda << ") " << config.model << " with " << config.strategy << " play: "
+              << config.games << " games, alpha " << config.alpha << ", trace " << maxTrace << ", "
+              << pool.size() << " threads\n";
+    std::cout << std::fixed << std::setprecision(1);
+
+    int played = 0;
+    for (int checkpoint = 0; played < config.games; ++checkpoint) {
+        auto start = std::chrono::high_resolution_clock::now();
+        const int count = std::min(config.checkpointEvery, config.games - played);
+
+        // Derived from (seed, checkpoint) so a run is reproducible up to thread interleaving
+        // seed_seq keeps 32 bits of each value, so the seed goes in as two words
+        std::seed_seq seq{static_cast<uint32_t>(config.seed), static_cast<uint32_t>(config.seed >> 32),
+                          static_cast<uint32_t>(checkpoint)};
+        std::mt19937_64 rng(seq);
+        const std::vector<uint64_t> gameSeeds = makeGameSeeds(rng(), count);
+
+        std::atomic<int64_t> totalScore{0};
+        pool.parallelFor(gameSeeds.size(), [&](size_t g, int worker) {
+            totalScore += trainGame(*model, *players[worker], gameSeeds[g], config, maxTrace);
+        });
+        played += count;
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = end - start;
+        std::cout << "Games " << played << ": training mean " << static_cast<double>(totalScore) / count
+                  << " (" << count / elapsed.count() << " games/s)";
+
+        if (!config.snapshotDir.empty()) {
+            const std::string path = config.snapshotDir + "/snapshot_" + std::to_string(played) + model->extension();
+            if (!model->save(path)) {
+                std::cerr << "\nWarning: cannot write snapshot " << path << "\n";
+            }
+        }
+
+        if (config.evalGames > 0) {
+            RunningStats stats = evaluateSuite(model->freeze(), evalSeeds, config, pool);
+            std::cout << ", eval " << stats.mean() << " +/- " << stats.ciHalfWidth();
+            if (stats.mean() > bestMean) {
+                bestMean = stats.mean();
+                if (!model->save(config.outputPath)) {
+                    std::cerr << "\nWarning: cannot write weights " << config.outputPath << "\n";
+                }
+                std::cout << " (best)";
+            }
+        } else if (!model->save(config.outputPath)) {
+            std::cerr << "\nWarning: cannot write weights " << config.outputPath << "\n";
+        }
+        std::cout << "\n" << std::flush;
+    }
+
+    std::cout << "Weights written to " << config.outputPath << "\n";
+    return 0;
+}
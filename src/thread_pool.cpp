@@ -0,0 +1,86 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace BlockGame {
+
+ThreadPool::ThreadPool(int numThreads)
+    : numThreads_(numThreads > 0 ? numThreads
+                                 : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))) {
+    // The calling thread acts as worker 0
+    for (int i = 1; i < numThreads_; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, int)>& fn) {
+    if (count == 0) return;
+
+    // Not worth waking anyone for a single item
+    if (numThreads_ == 1 || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &fn;
+        jobCount_ = count;
+        nextIndex_ = 0;
+        activeWorkers_ = numThreads_ - 1;
+        generation_++;
+    }
+    wake_.notify_all();
+
+    runJob(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return activeWorkers_ == 0; });
+    job_ = nullptr;
+}
+
+void ThreadPool::runJob(int worker) {
+    for (;;) {
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (nextIndex_ >= jobCount_) return;
+            index = nextIndex_++;
+        }
+        (*job_)(index, worker);
+    }
+}
+
+void ThreadPool::workerLoop(int worker) {
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seenGeneration; });
+            if (stopping_) return;
+            seenGeneration = generation_;
+        }
+
+        runJob(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            activeWorkers_--;
+        }
+        done_.notify_one();
+    }
+}
+
+} // namespace BlockGame
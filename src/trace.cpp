@@ -0,0 +1,171 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace BlockGame {
+
+namespace {
+
+struct SiteStats {
+    uint64_t calls = 0;
+    uint64_t nanos = 0;
+    uint64_t count = 0;
+};
+
+struct TraceEvent {
+    int site;
+    uint64_t start;
+    uint64_t duration;
+};
+
+struct ThreadData {
+    int tid = 0;
+    std::vector<SiteStats> sites;       // Indexed by site id, grown on first use
+    std::vector<TraceEvent> events;
+    uint64_t dropped = 0;
+};
+
+/**
+ * Owns the site names and every thread's table, so the tables outlive their
+ * threads and can be merged when the registry is destroyed at exit.
+ */
+class Registry {
+public:
+    Registry() : epoch_(Trace::now()) {
+        if (const char* path = std::getenv("BLOCKGAME_TRACE_JSON")) jsonPath_ = path;
+    }
+
+    ~Registry() {
+        report();
+        if (!jsonPath_.empty()) writeTimeline();
+    }
+
+    int site(const char* name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        names_.push_back(name);
+        return static_cast<int>(names_.size()) - 1;
+    }
+
+    ThreadData* attach() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.push_back(std::make_unique<ThreadData>());
+        threads_.back()->tid = static_cast<int>(threads_.size());
+        return threads_.back().get();
+    }
+
+    [[nodiscard]] bool timeline() const { return !jsonPath_.empty(); }
+
+private:
+    std::mutex mutex_;
+    std::vector<const char*> names_;
+    std::vector<std::unique_ptr<ThreadData>> threads_;
+    std::string jsonPath_;
+    uint64_t epoch_;
+
+    void report() const {
+        if (names_.empty()) return;
+        std::vector<SiteStats> total(names_.size());
+        for (const auto& thread : threads_) {
+            for (size_t s = 0; s < thread->sites.size(); ++s) {
+                total[s].calls += thread->sites[s].calls;
+                total[s].nanos += thread->sites[s].nanos;
+                total[s].count += thread->sites[s].count;
+            }
+        }
+
+        std::vector<size_t> order(names_.size());
+        for (size_t s = 0; s < order.size(); ++s) order[s] = s;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return total[a].nanos > total[b].nanos; });
+
+        std::fprintf(stderr, "\nTrace summary (%zu threads, inclusive times)\n", threads_.size());
+        std::fprintf(stderr, "%-36s %14s %12s %12s\n", "timer", "calls", "total ms", "ns/call");
+        for (size_t s : order) {
+            if (!total[s].calls) continue;
+            std::fprintf(stderr, "%-36s %14llu %12.3f %12.1f\n", names_[s],
+                         static_cast<unsigned long long>(total[s].calls), total[s].nanos / 1e6,
+                         static_cast<double>(total[s].nanos) / total[s].calls);
+        }
+        std::fprintf(stderr, "%-36s %14s\n", "counter", "count");
+        for (size_t s = 0; s < names_.size(); ++s) {
+            if (!total[s].count) continue;
+            std::fprintf(stderr, "%-36s %14llu\n", names_[s], static_cast<unsigned long long>(total[s].count));
+        }
+    }
+
+    void writeTimeline() const {
+        FILE* f = std::fopen(jsonPath_.c_str(), "w");
+        if (!f) {
+            std::fprintf(stderr, "Error: cannot write trace to %s\n", jsonPath_.c_str());
+            return;
+        }
+        // Site names are string literals chosen in the source, so they need no escaping
+        std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        bool first = true;
+        uint64_t dropped = 0;
+        for (const auto& thread : threads_) {
+            dropped += thread->dropped;
+            for (const TraceEvent& e : thread->events) {
+                std::fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                             first ? "" : ",\n", names_[e.site], thread->tid, (e.start - epoch_) / 1e3,
+                             e.duration / 1e3);
+                first = false;
+            }
+        }
+        std::fprintf(f, "\n]}\n");
+        std::fclose(f);
+        std::fprintf(stderr, "Trace timeline written to %s", jsonPath_.c_str());
+        if (dropped) std::fprintf(stderr, " (%llu events dropped)", static_cast<unsigned long long>(dropped));
+        std::fprintf(stderr, "\n");
+    }
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+thread_local ThreadData* localData = nullptr;
+
+SiteStats& localStats(int site) {
+    if (!localData) localData = registry().attach();
+    auto& sites = localData->sites;
+    if (static_cast<size_t>(site) >= sites.size()) sites.resize(site + 1);
+    return sites[site];
+}
+
+} // anonymous namespace
+
+int Trace::site(const char* name) {
+    return registry().site(name);
+}
+
+uint64_t Trace::now() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+void Trace::record(int site, uint64_t start, uint64_t duration) {
+    SiteStats& stats = localStats(site);
+    stats.calls++;
+    stats.nanos += duration;
+    if (registry().timeline()) {
+        if (localData->events.size() < MAX_EVENTS_PER_THREAD) {
+            localData->events.push_back({site, start, duration});
+        } else {
+            localData->dropped++;
+        }
+    }
+}
+
+void Trace::count(int site, uint64_t n) {
+    localStats(site).count += n;
+}
+
+} // namespace BlockGame
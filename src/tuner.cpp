@@ -0,0 +1,352 @@
+#include "evaluator.hpp"
+#include "simulation.hpp"
+#include "statistics.hpp"
+#include "strategy.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace BlockGame;
+
+/**
+ * Cross-entropy method over heuristic weights.
+ *
+ * Each generation samples a population from a diagonal Gaussian, plays every
+ * candidate on the same seeded games (common random numbers, so differences
+ * between candidates are not drowned by hand luck), and refits the Gaussian
+ * to the elite fraction.
+ */
+struct TunerConfig {
+    std::string strategy = "greedy";
+    int games = 32;             // Games per candidate
+    int population = 16;
+    double eliteFraction = 0.25;
+    double smoothing = 0.7;     // Weight of the new elite fit in the update
+    double minSigma = 0.01;
+    int generations = 20;
+    uint64_t seed = 1;
+    int threads = 0;
+    bool freshGames = false;    // Draw a new game set every generation
+    std::string checkpointPath = "tuner_state.txt";
+    std::string outputPath = "tuned_weights.txt";
+};
+
+struct TunerState {
+    // The run the checkpoint belongs to; --resume refuses a different one
+    uint64_t seed = 0;
+    int games = 0;
+    bool freshGames = false;
+
+    int generation = 0;
+    FeatureVector mean{};
+    FeatureVector sigma{};
+    double bestFitness = -1;
+    FeatureVector best{};
+
+    static TunerState initial() {
+        TunerState state;
+        state.mean = HeuristicWeights::defaults().w;
+        for (int i = 0; i < NUM_FEATURES; ++i) {
+            state.sigma[i] = 0.5 * std::abs(state.mean[i]) + 0.1;
+        }
+        state.best = state.mean;
+        return state;
+    }
+
+    bool save(const std::string& path) const {
+        // Write then rename so an interrupted run never leaves a torn checkpoint
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp);
+            if (!out) return false;
+            out << std::setprecision(17);
+            out << "seed " << seed << "\n";
+            out << "games " << games << "\n";
+            out << "fresh_games " << freshGames << "\n";
+            out << "generation " << generation << "\n";
+            out << "best_fitness " << bestFitness << "\n";
+            writeVector(out, "mean", mean);
+            writeVector(out, "sigma", sigma);
+            writeVector(out, "best", best);
+            if (!out) return false;
+        }
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string key;
+        int found = 0;
+        while (in >> key) {
+            if (key == "seed") {
+                in >> seed;
+            } else if (key == "games") {
+                in >> games;
+            } else if (key == "fresh_games") {
+                in >> freshGames;
+            } else if (key == "generation") {
+                in >> generation;
+            } else if (key == "best_fitness") {
+                in >> bestFitness;
+            } else if (key == "mean") {
+                readVector(in, mean);
+            } else if (key == "sigma") {
+                readVector(in, sigma);
+            } else if (key == "best") {
+                readVector(in, best);
+            } else {
+                return false;
+            }
+            found++;
+        }
+        return found == 8 && !in.bad();
+    }
+
+private:
+    static void writeVector(std::ostream& out, const char* key, const FeatureVector& v) {
+        out << key;
+        for (double x : v) out << " " << x;
+        out << "\n";
+    }
+
+    static void readVector(std::istream& in, FeatureVector& v) {
+        for (double& x : v) in >> x;
+    }
+};
+
+// Mean score of every candidate over the same games, spread over all workers
+std::vector<double> evaluatePopulation(const std::vector<FeatureVector>& candidates,
+                                       const std::vector<uint64_t>& gameSeeds,
+                                       const TunerConfig& config, ThreadPool& pool) {
+    const size_t numGames = gameSeeds.size();
+    std::vector<int> scores(candidates.size() * numGames);
+
+    // Searches inside the strategy stay single threaded, parallelism is across games
+    BeamConfig beamConfig;
+    beamConfig.threads = 1;
+
+    pool.parallelFor(scores.size(), [&](size_t task, int) {
+        const size_t c = task / numGames;
+        const size_t g = task % numGames;
+        auto evaluator = std::make_shared<HeuristicEvaluator>(HeuristicWeights{candidates[c]});
+        auto strategy = makeStrategy(config.strategy, gameSeeds[g], beamConfig, evaluator);
+        Game game(gameSeeds[g]);
+        scores[task] = strategy->playGame(game);
+    });
+
+    std::vector<double> fitness(candidates.size());
+    for (size_t c = 0; c < candidates.size(); ++c) {
+        std::vector<int> candidateScores(scores.begin() + c * numGames, scores.begin() + (c + 1) * numGames);
+        fitness[c] = Statistics::compute(candidateScores).mean;
+    }
+    return fitness;
+}
+
+void printVector(const char* label, const FeatureVector& v) {
+    std::cout << "  " << std::left << std::setw(8) << label << std::right;
+    for (double x : v) std::cout << std::setw(10) << x;
+    std::cout << "\n";
+}
+
+void printUsage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n";
+    std::cerr << "  --strategy NAME    greedy or beam (default: greedy)\n";
+    std::cerr << "  --games N          Games per candidate (default: 32)\n";
+    std::cerr << "  --population N     Candidates per generation (default: 16)\n";
+    std::cerr << "  --elite F          Elite fraction (default: 0.25)\n";
+    std::cerr << "  --generations N    Generations to run in total (default: 20)\n";
+    std::cerr << "  --seed N           Seed for game sets and sampling (default: 1)\n";
+    std::cerr << "  --fresh-games      Draw a new seeded game set each generation\n";
+    std::cerr << "  --threads N        Worker threads, 0 = all cores (default: 0)\n";
+    std::cerr << "  --checkpoint FILE  Optimizer state file (default: tuner_state.txt)\n";
+    std::cerr << "  --resume           Continue from the checkpoint file, with the same --seed,\n";
+    std::cerr << "                     --games and --fresh-games\n";
+    std::cerr << "  --output FILE      Best weights file (default: tuned_weights.txt)\n";
+}
+
+int main(int argc, char* argv[]) {
+    TunerConfig config;
+    bool resume = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg == "--resume") {
+            resume = true;
+            continue;
+        } else if (arg == "--fresh-games") {
+            config.freshGames = true;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--strategy") {
+                config.strategy = value;
+            } else if (arg == "--games") {
+                config.games = std::stoi(value);
+            } else if (arg == "--population") {
+                config.population = std::stoi(value);
+            } else if (arg == "--elite") {
+                config.eliteFraction = std::stod(value);
+            } else if (arg == "--generations") {
+                config.generations = std::stoi(value);
+            } else if (arg == "--seed") {
+                config.seed = std::stoull(value);
+            } else if (arg == "--threads") {
+                config.threads = std::stoi(value);
+            } else if (arg == "--checkpoint") {
+                config.checkpointPath = value;
+            } else if (arg == "--output") {
+                config.outputPath = value;
+            } else {
+                std::cerr << "Error: unknown option " << arg << "\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.strategy != "greedy" && config.strategy != "beam") {
+        std::cerr << "Error: strategy " << config.strategy << " has no tunable evaluator\n";
+        return 1;
+    }
+    if (config.games <= 0 || config.population < 2) {
+        std::cerr << "Error: need at least 1 game and 2 candidates\n";
+        return 1;
+    }
+    if (!(config.eliteFraction > 0 && config.eliteFraction <= 1)) {
+        std::cerr << "Error: --elite must be in (0, 1]\n";
+        return 1;
+    }
+
+    TunerState state = TunerState::initial();
+    state.seed = config.seed;
+    state.games = config.games;
+    state.freshGames = config.freshGames;
+    if (resume) {
+        if (!state.load(config.checkpointPath)) {
+            std::cerr << "Error: cannot load checkpoint " << config.checkpointPath << "\n";
+            return 1;
+        }
+        // Another seed or game set would silently continue a different run
+        if (state.seed != config.seed || state.games != config.games || state.freshGames != config.freshGames) {
+            std::cerr << "Error: checkpoint " << config.checkpointPath << " was written with --seed " << state.seed
+                      << " --games " << state.games << (state.freshGames ? " --fresh-games" : "")
+                      << "; resume with the same options\n";
+            return 1;
+        }
+        std::cout << "Resumed from " << config.checkpointPath << " at generation " << state.generation << "\n";
+    }
+
+    ThreadPool pool(config.threads);
+    const int numElite =
+        std::clamp(static_cast<int>(config.population * config.eliteFraction), 1, config.population);
+
+    std::cout << "Tuning " << config.strategy << " weights: population " << config.population
+              << ", elite " << numElite << ", " << config.games << " games/candidate, "
+              << pool.size() << " threads\n";
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "  " << std::setw(8) << "";
+    for (int i = 0; i < NUM_FEATURES; ++i) {
+        std::string name = featureName(static_cast<Feature>(i));
+        std::cout << std::setw(10) << name.substr(0, 9);
+    }
+    std::cout << "\n";
+
+    std::vector<uint64_t> gameSeeds = makeGameSeeds(config.seed, config.games);
+
+    while (state.generation < config.generations) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        // Derived from (seed, generation) so a resumed run samples exactly what the original would have
+        // seed_seq keeps 32 bits of each value, so the seed goes in as two words
+        std::seed_seq seq{static_cast<uint32_t>(config.seed), static_cast<uint32_t>(config.seed >> 32),
+                          static_cast<uint32_t>(state.generation)};
+        std::mt19937_64 rng(seq);
+        if (config.freshGames) {
+            gameSeeds = makeGameSeeds(rng(), config.games);
+        }
+
+        // Candidate 0 is the current mean, so progress of the distribution itself is visible
+        std::vector<FeatureVector> candidates(config.population);
+        candidates[0] = state.mean;
+        for (int c = 1; c < config.population; ++c) {
+            for (int i = 0; i < NUM_FEATURES; ++i) {
+                std::normal_distribution<double> dist(state.mean[i], state.sigma[i]);
+                candidates[c][i] = dist(rng);
+            }
+        }
+
+        std::vector<double> fitness = evaluatePopulation(candidates, gameSeeds, config, pool);
+
+        std::vector<int> order(config.population);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return fitness[a] > fitness[b]; });
+
+        // Refit the Gaussian to the elite
+        FeatureVector eliteMean{};
+        FeatureVector eliteVar{};
+        for (int e = 0; e < numElite; ++e) {
+            for (int i = 0; i < NUM_FEATURES; ++i) eliteMean[i] += candidates[order[e]][i] / numElite;
+        }
+        for (int e = 0; e < numElite; ++e) {
+            for (int i = 0; i < NUM_FEATURES; ++i) {
+                double d = candidates[order[e]][i] - eliteMean[i];
+                eliteVar[i] += d * d / numElite;
+            }
+        }
+        for (int i = 0; i < NUM_FEATURES; ++i) {
+            state.mean[i] = config.smoothing * eliteMean[i] + (1 - config.smoothing) * state.mean[i];
+            state.sigma[i] = std::max(config.minSigma,
+                                      config.smoothing * std::sqrt(eliteVar[i]) + (1 - config.smoothing) * state.sigma[i]);
+        }
+
+        if (fitness[order[0]] > state.bestFitness) {
+            state.bestFitness = fitness[order[0]];
+            state.best = candidates[order[0]];
+        }
+        state.generation++;
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = end - start;
+        double meanFitness = std::accumulate(fitness.begin(), fitness.end(), 0.0) / fitness.size();
+
+        std::cout << "Generation " << state.generation << ": best " << fitness[order[0]]
+                  << ", population mean " << meanFitness
+                  << ", current mean " << fitness[0]
+                  << " (" << elapsed.count() << "s)\n";
+        printVector("mean", state.mean);
+        printVector("sigma", state.sigma);
+
+        if (!state.save(config.checkpointPath)) {
+            std::cerr << "Warning: cannot write checkpoint " << config.checkpointPath << "\n";
+        }
+        if (!HeuristicWeights{state.best}.save(config.outputPath)) {
+            std::cerr << "Warning: cannot write weights " << config.outputPath << "\n";
+        }
+    }
+
+    std::cout << "Best fitness " << state.bestFitness << ", weights written to " << config.outputPath << "\n";
+    printVector("best", state.best);
+    return 0;
+}